@@ -21,6 +21,7 @@
 #include "FirebaseAdMobScene.h"
 
 #include <stdarg.h>
+#include <stdlib.h>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include <android/log.h>
@@ -29,6 +30,8 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseReplay.h"
 #include "firebase/admob.h"
 
 USING_NS_CC;
@@ -112,18 +115,39 @@ static const int kBirthdayDay = 10;
 static const int kBirthdayMonth = 11;
 static const int kBirthdayYear = 1976;
 
+/// The FirebaseReplay channels of the listeners' callbacks.
+static const char kAdViewStateChannel[] = "admob.banner.state";
+static const char kAdViewBoundingBoxChannel[] = "admob.banner.box";
+static const char kInterstitialStateChannel[] = "admob.interstitial.state";
+static const char kRewardedVideoStateChannel[] = "admob.rewarded.state";
+static const char kRewardedVideoRewardChannel[] = "admob.rewarded.reward";
+
 /// A simple listener that logs changes to an ad view.
-class LoggingAdViewListener : public firebase::admob::BannerView::Listener {
+class LoggingAdViewListener
+    : public firebase::admob::BannerView::Listener,
+      public FirebaseTracked<LoggingAdViewListener, true> {
  public:
   LoggingAdViewListener(FirebaseScene* scene) : scene(scene) {}
+  static const char* trackedName() { return "LoggingAdViewListener"; }
   void OnPresentationStateChanged(
       firebase::admob::BannerView* adView,
       firebase::admob::BannerView::PresentationState state) override {
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(kAdViewStateChannel,
+                             {FirebaseReplay::formatInt(state)});
+    }
     scene->logMessage("The ad view's PresentationState has changed to %d.",
                       state);
   }
   void OnBoundingBoxChanged(firebase::admob::BannerView* adView,
                             firebase::admob::BoundingBox box) override {
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(
+          kAdViewBoundingBoxChannel,
+          {FirebaseReplay::formatInt(box.x), FirebaseReplay::formatInt(box.y),
+           FirebaseReplay::formatInt(box.width),
+           FirebaseReplay::formatInt(box.height)});
+    }
     scene->logMessage(
         "The ad view's BoundingBox has changed to (x: %d, y: %d, width: %d, "
         "height %d).",
@@ -136,12 +160,18 @@ class LoggingAdViewListener : public firebase::admob::BannerView::Listener {
 
 /// A simple listener that logs changes to an InterstitialAd.
 class LoggingInterstitialAdListener
-    : public firebase::admob::InterstitialAd::Listener {
+    : public firebase::admob::InterstitialAd::Listener,
+      public FirebaseTracked<LoggingInterstitialAdListener, true> {
  public:
   LoggingInterstitialAdListener(FirebaseScene* scene) : scene(scene) {}
+  static const char* trackedName() { return "LoggingInterstitialAdListener"; }
   void OnPresentationStateChanged(
       firebase::admob::InterstitialAd* interstitialAd,
       firebase::admob::InterstitialAd::PresentationState state) override {
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(kInterstitialStateChannel,
+                             {FirebaseReplay::formatInt(state)});
+    }
     scene->logMessage("InterstitialAd PresentationState has changed to %d.",
                       state);
   }
@@ -151,15 +181,27 @@ class LoggingInterstitialAdListener
 };
 
 /// A simple listener that logs changes to rewarded video state.
-class LoggingRewardedVideoListener : public rewarded_video::Listener {
+class LoggingRewardedVideoListener
+    : public rewarded_video::Listener,
+      public FirebaseTracked<LoggingRewardedVideoListener, true> {
  public:
   LoggingRewardedVideoListener(FirebaseScene* scene) : scene(scene) {}
+  static const char* trackedName() { return "LoggingRewardedVideoListener"; }
   void OnRewarded(rewarded_video::RewardItem reward) override {
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(
+          kRewardedVideoRewardChannel,
+          {FirebaseReplay::formatDouble(reward.amount), reward.reward_type});
+    }
     scene->logMessage("Rewarding user with %f %s.", reward.amount,
                       reward.reward_type.c_str());
   }
   void OnPresentationStateChanged(
       rewarded_video::PresentationState state) override {
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(kRewardedVideoStateChannel,
+                             {FirebaseReplay::formatInt(state)});
+    }
     scene->logMessage("Rewarded video PresentationState has changed to %d.",
                       state);
   }
@@ -168,17 +210,20 @@ class LoggingRewardedVideoListener : public rewarded_video::Listener {
   FirebaseScene* scene;
 };
 
+// The completion callbacks below are called on the cocos thread by
+// FirebaseCompletionDispatcher, which carries each operation's trace span
+// with it, so overlapping operations each end their own span.
+
 /// This function is called when the Future for the last call to the ad view's
 /// Initialize() method completes.
 static void onAdViewInitializeCompletionCallback(
-    const firebase::Future<void>& future, void* userData) {
-  FirebaseScene* scene = static_cast<FirebaseScene*>(userData);
+    const firebase::Future<void>& future, FirebaseScene* scene) {
   if (future.error() == firebase::admob::kAdMobErrorNone) {
     scene->logMessage("Initializing the ad view completed successfully.");
   } else {
     scene->logMessage("Initializing the ad view failed.");
-    scene->logMessage(
-        "ERROR: Action failed with error code %d and message \"%s\".",
+    FIREBASE_COCOS_LOG_ERROR(
+        scene, "Action failed with error code %d and message \"%s\".",
         future.error(), future.error_message());
   }
 }
@@ -186,14 +231,13 @@ static void onAdViewInitializeCompletionCallback(
 /// This function is called when the Future for the last call to the ad view's
 /// LoadAd() method completes.
 static void onAdViewLoadAdCompletionCallback(
-    const firebase::Future<void>& future, void* userData) {
-  FirebaseScene* scene = static_cast<FirebaseScene*>(userData);
+    const firebase::Future<void>& future, FirebaseScene* scene) {
   if (future.error() == firebase::admob::kAdMobErrorNone) {
     scene->logMessage("Loading the ad view completed successfully.");
   } else {
     scene->logMessage("Loading the ad view failed.");
-    scene->logMessage(
-        "ERROR: Action failed with error code %d and message \"%s\".",
+    FIREBASE_COCOS_LOG_ERROR(
+        scene, "Action failed with error code %d and message \"%s\".",
         future.error(), future.error_message());
   }
 }
@@ -201,15 +245,14 @@ static void onAdViewLoadAdCompletionCallback(
 /// This function is called when the Future for the last call to the
 /// InterstitialAds's Initialize() method completes.
 static void onInterstitialAdInitializeCompletionCallback(
-    const firebase::Future<void>& future, void* userData) {
-  FirebaseScene* scene = static_cast<FirebaseScene*>(userData);
+    const firebase::Future<void>& future, FirebaseScene* scene) {
   if (future.error() == firebase::admob::kAdMobErrorNone) {
     scene->logMessage(
         "Initializing the interstitial ad completed successfully.");
   } else {
     scene->logMessage("Initializing the interstitial ad failed.");
-    scene->logMessage(
-        "ERROR: Action failed with error code %d and message \"%s\".",
+    FIREBASE_COCOS_LOG_ERROR(
+        scene, "Action failed with error code %d and message \"%s\".",
         future.error(), future.error_message());
   }
 }
@@ -217,14 +260,13 @@ static void onInterstitialAdInitializeCompletionCallback(
 /// This function is called when the Future for the last call to the
 /// InterstitialAds's LoadAd() method completes.
 static void onInterstitialAdLoadAdCompletionCallback(
-    const firebase::Future<void>& future, void* userData) {
-  FirebaseScene* scene = static_cast<FirebaseScene*>(userData);
+    const firebase::Future<void>& future, FirebaseScene* scene) {
   if (future.error() == firebase::admob::kAdMobErrorNone) {
     scene->logMessage("Loading the interstitial ad completed successfully.");
   } else {
     scene->logMessage("Loading the interstitial ad failed.");
-    scene->logMessage(
-        "ERROR: Action failed with error code %d and message \"%s\".",
+    FIREBASE_COCOS_LOG_ERROR(
+        scene, "Action failed with error code %d and message \"%s\".",
         future.error(), future.error_message());
   }
 }
@@ -232,14 +274,13 @@ static void onInterstitialAdLoadAdCompletionCallback(
 /// This function is called when the Future for the last call to
 /// rewarded_video::Initialize() method completes.
 static void onRewardedVideoInitializeCompletionCallback(
-    const firebase::Future<void>& future, void* userData) {
-  FirebaseScene* scene = static_cast<FirebaseScene*>(userData);
+    const firebase::Future<void>& future, FirebaseScene* scene) {
   if (future.error() == firebase::admob::kAdMobErrorNone) {
     scene->logMessage("Initializing rewarded video completed successfully.");
   } else {
     scene->logMessage("Initializing rewarded video failed.");
-    scene->logMessage(
-        "ERROR: Action failed with error code %d and message \"%s\".",
+    FIREBASE_COCOS_LOG_ERROR(
+        scene, "Action failed with error code %d and message \"%s\".",
         future.error(), future.error_message());
   }
 }
@@ -247,28 +288,30 @@ static void onRewardedVideoInitializeCompletionCallback(
 /// This function is called when the Future for the last call to
 /// rewarded_video::LoadAd() method completes.
 static void onRewardedVideoLoadAdCompletionCallback(
-    const firebase::Future<void>& future, void* userData) {
-  FirebaseScene* scene = static_cast<FirebaseScene*>(userData);
+    const firebase::Future<void>& future, FirebaseScene* scene) {
   if (future.error() == firebase::admob::kAdMobErrorNone) {
     scene->logMessage("Loading rewarded video completed successfully.");
   } else {
     scene->logMessage("Loading rewarded video failed.");
-    scene->logMessage(
-        "ERROR: Action failed with error code %d and message \"%s\".",
+    FIREBASE_COCOS_LOG_ERROR(
+        scene, "Action failed with error code %d and message \"%s\".",
         future.error(), future.error_message());
     // Rewarded Video returned an error. This might be because the developer did
     // not put their Rewarded Video ad unit into kRewardedVideoAdUnit above.
-    scene->logMessage("WARNING: Is your Rewarded Video ad unit ID correct?");
+    FIREBASE_COCOS_LOG_WARN(scene,
+                            "Is your Rewarded Video ad unit ID correct?");
     scene->logMessage(
         "Ensure kRewardedVideoAdUnit is set to your own Rewarded Video ad unit "
         "ID.");
   }
 }
 
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseAdMobScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseAdMobScene.
 Scene* FirebaseAdMobScene::createScene() {
@@ -301,6 +344,7 @@ bool FirebaseAdMobScene::init() {
   adViewListener = new LoggingAdViewListener(this);
   interstitialAdListener = new LoggingInterstitialAdListener(this);
   rewardedVideoListener = new LoggingRewardedVideoListener(this);
+  setReplayHandlers();
 
   // Create the Firebase label.
   auto firebaseLabel =
@@ -329,13 +373,18 @@ bool FirebaseAdMobScene::init() {
   adSize.height = kAdViewHeight;
   logMessage("Initializing the ad view.");
   adView->Initialize(getWindowContext(), kAdViewAdUnit, adSize);
-  adView->InitializeLastResult().OnCompletion(
-      onAdViewInitializeCompletionCallback, this);
+  FirebaseCompletionDispatcher::onCompletion(
+      adView->InitializeLastResult(), this,
+      [this](const firebase::Future<void>& future) {
+        onAdViewInitializeCompletionCallback(future, this);
+      },
+      FirebaseTrace::begin("AdMob BannerView Initialize"));
 
   // Set up the load ad view button.
   loadAdViewBtn = createButton(true, kLoadAdViewText);
   loadAdViewBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob load ad view button");
         cocos2d::ui::Button* button = static_cast<cocos2d::ui::Button*>(sender);
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED:
@@ -350,8 +399,12 @@ bool FirebaseAdMobScene::init() {
             adView->SetListener(adViewListener);
             logMessage("Loading the ad view.");
             adView->LoadAd(createAdRequest());
-            adView->LoadAdLastResult().OnCompletion(
-                onAdViewLoadAdCompletionCallback, this);
+            FirebaseCompletionDispatcher::onCompletion(
+                adView->LoadAdLastResult(), this,
+                [this](const firebase::Future<void>& future) {
+                  onAdViewLoadAdCompletionCallback(future, this);
+                },
+                FirebaseTrace::begin("AdMob BannerView LoadAd"));
             break;
           default:
             break;
@@ -363,6 +416,7 @@ bool FirebaseAdMobScene::init() {
   showHideAdViewBtn = createButton(false, kShowAdViewText);
   showHideAdViewBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob show hide ad view button");
         cocos2d::ui::Button* button = static_cast<cocos2d::ui::Button*>(sender);
         std::string titleText = button->getTitleText();
         switch (type) {
@@ -387,6 +441,7 @@ bool FirebaseAdMobScene::init() {
   moveAdViewBtn = createButton(false, kMoveAdViewText);
   moveAdViewBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob move ad view button");
         firebase::admob::BannerView::Position adViewPosition =
             static_cast<firebase::admob::BannerView::Position>(
                 adViewPositions[adViewPositionIndex]);
@@ -410,13 +465,18 @@ bool FirebaseAdMobScene::init() {
   interstitialAd = new firebase::admob::InterstitialAd();
   logMessage("Initializing the interstitial ad.");
   interstitialAd->Initialize(getWindowContext(), kInterstitialAdUnit);
-  interstitialAd->InitializeLastResult().OnCompletion(
-      onInterstitialAdInitializeCompletionCallback, this);
+  FirebaseCompletionDispatcher::onCompletion(
+      interstitialAd->InitializeLastResult(), this,
+      [this](const firebase::Future<void>& future) {
+        onInterstitialAdInitializeCompletionCallback(future, this);
+      },
+      FirebaseTrace::begin("AdMob InterstitialAd Initialize"));
 
   // Set up the load interstitial ad button.
   loadInterstitialAdBtn = createButton(true, kLoadInterstitialText);
   loadInterstitialAdBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob load interstitial ad button");
         cocos2d::ui::Button* button = static_cast<cocos2d::ui::Button*>(sender);
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED:
@@ -429,8 +489,12 @@ bool FirebaseAdMobScene::init() {
             interstitialAd->SetListener(interstitialAdListener);
             logMessage("Loading the interstitial ad.");
             interstitialAd->LoadAd(createAdRequest());
-            interstitialAd->LoadAdLastResult().OnCompletion(
-                onInterstitialAdLoadAdCompletionCallback, this);
+            FirebaseCompletionDispatcher::onCompletion(
+                interstitialAd->LoadAdLastResult(), this,
+                [this](const firebase::Future<void>& future) {
+                  onInterstitialAdLoadAdCompletionCallback(future, this);
+                },
+                FirebaseTrace::begin("AdMob InterstitialAd LoadAd"));
             break;
           default:
             break;
@@ -442,6 +506,7 @@ bool FirebaseAdMobScene::init() {
   showInterstitialAdBtn = createButton(false, kShowInterstitialText);
   showInterstitialAdBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob show interstitial ad button");
         cocos2d::ui::Button* button = static_cast<cocos2d::ui::Button*>(sender);
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED:
@@ -463,13 +528,18 @@ bool FirebaseAdMobScene::init() {
 
   logMessage("Initializing rewarded video.");
   rewarded_video::Initialize();
-  rewarded_video::InitializeLastResult().OnCompletion(
-      onRewardedVideoInitializeCompletionCallback, this);
+  FirebaseCompletionDispatcher::onCompletion(
+      rewarded_video::InitializeLastResult(), this,
+      [this](const firebase::Future<void>& future) {
+        onRewardedVideoInitializeCompletionCallback(future, this);
+      },
+      FirebaseTrace::begin("AdMob rewarded_video Initialize"));
 
   // Set up the load rewarded video button.
   loadRewardedVideoBtn = createButton(true, kLoadRewardedVideoText);
   loadRewardedVideoBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob load rewarded video button");
         cocos2d::ui::Button* button = static_cast<cocos2d::ui::Button*>(sender);
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED:
@@ -482,8 +552,12 @@ bool FirebaseAdMobScene::init() {
             rewarded_video::SetListener(rewardedVideoListener);
             logMessage("Loading the rewarded video.");
             rewarded_video::LoadAd(kRewardedVideoAdUnit, createAdRequest());
-            rewarded_video::LoadAdLastResult().OnCompletion(
-                onRewardedVideoLoadAdCompletionCallback, this);
+            FirebaseCompletionDispatcher::onCompletion(
+                rewarded_video::LoadAdLastResult(), this,
+                [this](const firebase::Future<void>& future) {
+                  onRewardedVideoLoadAdCompletionCallback(future, this);
+                },
+                FirebaseTrace::begin("AdMob rewarded_video LoadAd"));
             break;
           default:
             break;
@@ -495,6 +569,7 @@ bool FirebaseAdMobScene::init() {
   showRewardedVideoBtn = createButton(false, kShowRewardedVideoText);
   showRewardedVideoBtn->addTouchEventListener(
       [&](Ref* sender, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("AdMob show rewarded video button");
         cocos2d::ui::Button* button = static_cast<cocos2d::ui::Button*>(sender);
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED:
@@ -538,6 +613,7 @@ bool FirebaseAdMobScene::init() {
 
 // Called automatically every frame. The update is scheduled in `init()`.
 void FirebaseAdMobScene::update(float delta) {
+  FIREBASE_COCOS_PROFILE_SCOPE("AdMob update");
   // If the ad view's Initialize() future has completed successfully, enable the
   // ad view buttons.
   if (adView->InitializeLastResult().status() ==
@@ -588,8 +664,12 @@ void FirebaseAdMobScene::update(float delta) {
       interstitialAd = new firebase::admob::InterstitialAd();
       logMessage("Initializing the interstitial ad.");
       interstitialAd->Initialize(getWindowContext(), kInterstitialAdUnit);
-      interstitialAd->InitializeLastResult().OnCompletion(
-          onInterstitialAdInitializeCompletionCallback, this);
+      FirebaseCompletionDispatcher::onCompletion(
+          interstitialAd->InitializeLastResult(), this,
+          [this](const firebase::Future<void>& future) {
+            onInterstitialAdInitializeCompletionCallback(future, this);
+          },
+          FirebaseTrace::begin("AdMob InterstitialAd Initialize"));
     }
     // If the InterstitialAd::LoadAd() future completed but there was an error,
     // then clean up the existing interstitial ad object and create a new one.
@@ -605,8 +685,12 @@ void FirebaseAdMobScene::update(float delta) {
       interstitialAd = new firebase::admob::InterstitialAd();
       logMessage("Reinitializing the interstitial ad.");
       interstitialAd->Initialize(getWindowContext(), kInterstitialAdUnit);
-      interstitialAd->InitializeLastResult().OnCompletion(
-          onInterstitialAdInitializeCompletionCallback, this);
+      FirebaseCompletionDispatcher::onCompletion(
+          interstitialAd->InitializeLastResult(), this,
+          [this](const firebase::Future<void>& future) {
+            onInterstitialAdInitializeCompletionCallback(future, this);
+          },
+          FirebaseTrace::begin("AdMob InterstitialAd Initialize"));
     }
   }
 
@@ -644,8 +728,12 @@ void FirebaseAdMobScene::update(float delta) {
       rewarded_video::Destroy();
       logMessage("Initializing rewarded video.");
       rewarded_video::Initialize();
-      rewarded_video::InitializeLastResult().OnCompletion(
-          onRewardedVideoInitializeCompletionCallback, this);
+      FirebaseCompletionDispatcher::onCompletion(
+          rewarded_video::InitializeLastResult(), this,
+          [this](const firebase::Future<void>& future) {
+            onRewardedVideoInitializeCompletionCallback(future, this);
+          },
+          FirebaseTrace::begin("AdMob rewarded_video Initialize"));
     }
     // If the rewarded_video::LoadAd() future completed but there was an error,
     // then clean up the existing rewarded_video namespace and reinitialize.
@@ -660,12 +748,65 @@ void FirebaseAdMobScene::update(float delta) {
       rewarded_video::Destroy();
       logMessage("Reinitializing rewarded video.");
       rewarded_video::Initialize();
-      rewarded_video::InitializeLastResult().OnCompletion(
-          onRewardedVideoInitializeCompletionCallback, this);
+      FirebaseCompletionDispatcher::onCompletion(
+          rewarded_video::InitializeLastResult(), this,
+          [this](const firebase::Future<void>& future) {
+            onRewardedVideoInitializeCompletionCallback(future, this);
+          },
+          FirebaseTrace::begin("AdMob rewarded_video Initialize"));
     }
   }
 }
 
+void FirebaseAdMobScene::setReplayHandlers() {
+  // The listeners don't use the ad passed to them, so replay passes null.
+  FirebaseReplay::setHandler(
+      kAdViewStateChannel, this, [this](const FirebaseReplay::Fields& fields) {
+        if (fields.empty()) return;
+        adViewListener->OnPresentationStateChanged(
+            nullptr,
+            static_cast<firebase::admob::BannerView::PresentationState>(
+                atoi(fields[0].c_str())));
+      });
+  FirebaseReplay::setHandler(
+      kAdViewBoundingBoxChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 4) return;
+        firebase::admob::BoundingBox box;
+        box.x = atoi(fields[0].c_str());
+        box.y = atoi(fields[1].c_str());
+        box.width = atoi(fields[2].c_str());
+        box.height = atoi(fields[3].c_str());
+        adViewListener->OnBoundingBoxChanged(nullptr, box);
+      });
+  FirebaseReplay::setHandler(
+      kInterstitialStateChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.empty()) return;
+        interstitialAdListener->OnPresentationStateChanged(
+            nullptr,
+            static_cast<firebase::admob::InterstitialAd::PresentationState>(
+                atoi(fields[0].c_str())));
+      });
+  FirebaseReplay::setHandler(
+      kRewardedVideoStateChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.empty()) return;
+        rewardedVideoListener->OnPresentationStateChanged(
+            static_cast<rewarded_video::PresentationState>(
+                atoi(fields[0].c_str())));
+      });
+  FirebaseReplay::setHandler(
+      kRewardedVideoRewardChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 2) return;
+        rewarded_video::RewardItem reward;
+        reward.amount = static_cast<float>(atof(fields[0].c_str()));
+        reward.reward_type = fields[1];
+        rewardedVideoListener->OnRewarded(reward);
+      });
+}
+
 firebase::admob::AdRequest FirebaseAdMobScene::createAdRequest() {
   firebase::admob::AdRequest request;
   // If the app is aware of the user's gender, it can be added to the targeting
@@ -713,6 +854,10 @@ firebase::admob::AdRequest FirebaseAdMobScene::createAdRequest() {
 /// Handles the user tapping on the close app menu item.
 void FirebaseAdMobScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up AdMob C++ resources.");
+  // The replay handlers use the listeners deleted below.
+  FirebaseReplay::removeHandlers(this);
+  // The update uses the ads, and may run again before the scene is removed.
+  this->unscheduleUpdate();
   delete adView;
   delete interstitialAd;
   rewarded_video::Destroy();
@@ -721,10 +866,5 @@ void FirebaseAdMobScene::menuCloseAppCallback(Ref* pSender) {
   delete rewardedVideoListener;
   firebase::admob::Terminate();
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
@@ -90,6 +90,9 @@ class FirebaseAdMobScene : public FirebaseScene {
 
   /// Returns an AdMob AdRequest.
   firebase::admob::AdRequest createAdRequest();
+
+  /// Hands replayed FirebaseReplay events to the listeners.
+  void setReplayHandlers();
 };
 
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_ADMOB_SCENE_H_
@@ -29,6 +29,7 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseLazyModule.h"
 #include "firebase/analytics.h"
 #include "firebase/app.h"
 #include "firebase/future.h"
@@ -53,10 +54,38 @@ static const cocos2d::Color3B kGreenButtonColor(0x3c, 0xba, 0x54);
 static const char* kButtonClickEvent = "button_clicked";
 static const char* kButtonColor = "button_color";
 
+/// Initializes Firebase Analytics. Called on the first button click.
+static firebase::InitResult initializeAnalytics(firebase::App* app) {
+  CCLOG("Initializing the Analytics with Firebase API.");
+  firebase::analytics::Initialize(*app);
+  return firebase::kInitResultSuccess;
+}
+
+/// Analytics is only initialized once an event is logged.
+static FirebaseLazyModule analyticsModule("Analytics", initializeAnalytics);
+
+/// Logs a button click event for the button `color`, with one extra
+/// parameter describing the click. Clicks made while Analytics is initializing
+/// are logged once it is ready.
+static void logButtonClickEvent(cocos2d::Ref* owner, const char* color,
+                                const firebase::analytics::Parameter& detail) {
+  analyticsModule.use(owner, [color, detail]() {
+    const firebase::analytics::Parameter kButtonClickParameters[] = {
+        firebase::analytics::Parameter(kButtonColor, color),
+        detail,
+    };
+    firebase::analytics::LogEvent(
+        kButtonClickEvent, kButtonClickParameters,
+        sizeof(kButtonClickParameters) / sizeof(kButtonClickParameters[0]));
+  });
+}
+
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseAnalyticsScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseAnalyticsScene.
 Scene* FirebaseAnalyticsScene::createScene() {
@@ -81,10 +110,6 @@ bool FirebaseAnalyticsScene::init() {
   auto visibleSize = Director::getInstance()->getVisibleSize();
   cocos2d::Vec2 origin = Director::getInstance()->getVisibleOrigin();
 
-  // Intitialize Firebase Analytics.
-  CCLOG("Initializing the Analytics with Firebase API.");
-  firebase::analytics::Initialize(*firebase::App::GetInstance());
-
   // Create the Firebase label.
   auto firebaseLabel =
       Label::createWithTTF("Firebase Analytics", "fonts/Marker Felt.ttf", 20);
@@ -107,6 +132,7 @@ bool FirebaseAnalyticsScene::init() {
   blue_button_ = createButton(true, kBlueButtonText, kBlueButtonColor);
   blue_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Analytics blue button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             // When the blue button is clicked it logs an event with parameters
@@ -117,15 +143,10 @@ bool FirebaseAnalyticsScene::init() {
             logMessage("Clicked the Blue Button. Total blue button clicks: %i",
                        this->blue_button_click_count_);
 
-            const firebase::analytics::Parameter kButtonClickParameters[] = {
-                firebase::analytics::Parameter(kButtonColor, "blue"),
+            logButtonClickEvent(
+                this, "blue",
                 firebase::analytics::Parameter("blue_button_click_count",
-                                               this->blue_button_click_count_),
-            };
-            firebase::analytics::LogEvent(
-                kButtonClickEvent, kButtonClickParameters,
-                sizeof(kButtonClickParameters) /
-                sizeof(kButtonClickParameters[0]));
+                                               this->blue_button_click_count_));
 
             this->previous_button_clicked_ = "blue";
             break;
@@ -141,6 +162,7 @@ bool FirebaseAnalyticsScene::init() {
   red_button_ = createButton(true, kRedButtonText, kRedButtonColor);
   red_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Analytics red button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             // When the red button is clicked it logs an event with parameters
@@ -150,15 +172,11 @@ bool FirebaseAnalyticsScene::init() {
             logMessage("Clicked the Red Button. Total button clicks: %i",
                        this->total_button_click_count_);
 
-            const firebase::analytics::Parameter kButtonClickParameters[] = {
-                firebase::analytics::Parameter(kButtonColor, "red"),
-                firebase::analytics::Parameter("total_button_click_count",
-                                               this->total_button_click_count_),
-            };
-            firebase::analytics::LogEvent(
-                kButtonClickEvent, kButtonClickParameters,
-                sizeof(kButtonClickParameters) /
-                sizeof(kButtonClickParameters[0]));
+            logButtonClickEvent(
+                this, "red",
+                firebase::analytics::Parameter(
+                    "total_button_click_count",
+                    this->total_button_click_count_));
 
             this->previous_button_clicked_ = "red";
             break;
@@ -174,6 +192,7 @@ bool FirebaseAnalyticsScene::init() {
   yellow_button_ = createButton(true, kYellowButtonText, kYellowButtonColor);
   yellow_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Analytics yellow button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             // When the yellow button is clicked it logs an event with
@@ -183,15 +202,10 @@ bool FirebaseAnalyticsScene::init() {
             logMessage("Clicked the Yellow Button. Previous button was: %s",
                        this->previous_button_clicked_);
 
-            const firebase::analytics::Parameter kButtonClickParameters[] = {
-                firebase::analytics::Parameter(kButtonColor, "yellow"),
+            logButtonClickEvent(
+                this, "yellow",
                 firebase::analytics::Parameter("previous_button",
-                                               this->previous_button_clicked_),
-            };
-            firebase::analytics::LogEvent(
-                kButtonClickEvent, kButtonClickParameters,
-                sizeof(kButtonClickParameters) /
-                sizeof(kButtonClickParameters[0]));
+                                               this->previous_button_clicked_));
 
             this->previous_button_clicked_ = "yellow";
             break;
@@ -207,6 +221,7 @@ bool FirebaseAnalyticsScene::init() {
   green_button_ = createButton(true, kGreenButtonText, kGreenButtonColor);
   green_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Analytics green button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             // When the green button is clicked it logs an event with
@@ -220,14 +235,9 @@ bool FirebaseAnalyticsScene::init() {
             logMessage("Clicked the Green Button. Green button ratio: %f",
                        ratio);
 
-            const firebase::analytics::Parameter kButtonClickParameters[] = {
-                firebase::analytics::Parameter(kButtonColor, "green"),
-                firebase::analytics::Parameter("green_click_ratio", ratio),
-            };
-            firebase::analytics::LogEvent(
-                kButtonClickEvent, kButtonClickParameters,
-                sizeof(kButtonClickParameters) /
-                sizeof(kButtonClickParameters[0]));
+            logButtonClickEvent(
+                this, "green",
+                firebase::analytics::Parameter("green_click_ratio", ratio));
 
             this->previous_button_clicked_ = "green";
             break;
@@ -255,23 +265,15 @@ bool FirebaseAnalyticsScene::init() {
   menu->setPosition(cocos2d::Vec2::ZERO);
   this->addChild(menu, 1);
 
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
-
   return true;
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
+// There is nothing to do each frame, so the update is not scheduled.
 void FirebaseAnalyticsScene::update(float /*delta*/) {}
 
 /// Handles the user tapping on the close app menu item.
 void FirebaseAnalyticsScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Analytics C++ resources.");
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
@@ -29,6 +29,8 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseLocalBackend.h"
 #include "firebase/auth.h"
 
 USING_NS_CC;
@@ -40,10 +42,12 @@ static const float kUIElementPadding = 10.0;
 static const char* kEmailPlaceholderText = "Email";
 static const char* kPasswordPlaceholderText = "Password";
 
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseAuthScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseAuthScene.
 Scene* FirebaseAuthScene::createScene() {
@@ -115,13 +119,16 @@ bool FirebaseAuthScene::init() {
   register_user_button_ = createButton(true, "Register user");
   register_user_button_->addTouchEventListener(
       [this, auth](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Auth register user button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             this->logMessage("Registering user...");
             const char* email = email_text_field_->getString().c_str();
             const char* password = password_text_field_->getString().c_str();
-            this->create_user_future_ =
-                auth->CreateUserWithEmailAndPassword(email, password);
+            FirebaseCompletionDispatcher::onCompletion(
+                auth->CreateUserWithEmailAndPassword(email, password), this,
+                CC_CALLBACK_1(FirebaseAuthScene::onCreateUserComplete, this),
+                FirebaseTrace::begin("Auth CreateUserWithEmailAndPassword"));
             this->register_user_button_->setEnabled(false);
             break;
           }
@@ -135,6 +142,7 @@ bool FirebaseAuthScene::init() {
   credentialed_sign_in_button_ = createButton(true, "Sign in");
   credentialed_sign_in_button_->addTouchEventListener(
       [this, auth](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Auth credentialed sign in button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             this->logMessage("Signing in...");
@@ -142,7 +150,10 @@ bool FirebaseAuthScene::init() {
             const char* password = password_text_field_->getString().c_str();
             Credential email_cred =
                 EmailAuthProvider::GetCredential(email, password);
-            this->sign_in_future_ = auth->SignInWithCredential(email_cred);
+            FirebaseCompletionDispatcher::onCompletion(
+                auth->SignInWithCredential(email_cred), this,
+                CC_CALLBACK_1(FirebaseAuthScene::onSignInComplete, this),
+                FirebaseTrace::begin("Auth SignInWithCredential"));
             this->credentialed_sign_in_button_->setEnabled(false);
             this->anonymous_sign_in_button_->setEnabled(false);
             this->sign_out_button_->setEnabled(true);
@@ -159,11 +170,24 @@ bool FirebaseAuthScene::init() {
   anonymous_sign_in_button_ = createButton(true, "Sign in anonymously");
   anonymous_sign_in_button_->addTouchEventListener(
       [this, auth](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Auth anonymous sign in button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             this->logMessage("Signing in anonymously...");
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+            FirebaseLocalBackend::signInAnonymously(
+                this,
+                [this](const FirebaseLocalBackend::Result& result) {
+                  onSignInResult(result.error, result.errorMessage.c_str());
+                },
+                FirebaseTrace::begin("Auth SignInAnonymously"));
+#else
             // Anonymous sign in must be enabled in the Firebase Console.
-            this->sign_in_future_ = auth->SignInAnonymously();
+            FirebaseCompletionDispatcher::onCompletion(
+                auth->SignInAnonymously(), this,
+                CC_CALLBACK_1(FirebaseAuthScene::onSignInComplete, this),
+                FirebaseTrace::begin("Auth SignInAnonymously"));
+#endif
             this->credentialed_sign_in_button_->setEnabled(false);
             this->anonymous_sign_in_button_->setEnabled(false);
             this->sign_out_button_->setEnabled(true);
@@ -180,6 +204,7 @@ bool FirebaseAuthScene::init() {
   sign_out_button_ = createButton(false, "Sign out");
   sign_out_button_->addTouchEventListener(
       [this, auth](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Auth sign out button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
             this->logMessage("Signed out");
@@ -212,55 +237,50 @@ bool FirebaseAuthScene::init() {
   menu->setPosition(cocos2d::Vec2::ZERO);
   this->addChild(menu, 1);
 
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
-
   return true;
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
-void FirebaseAuthScene::update(float /*delta*/) {
-  using firebase::auth::AuthError;
-  if (create_user_future_.status() == firebase::kFutureStatusComplete) {
-    const AuthError error = static_cast<AuthError>(create_user_future_.error());
-    if (error == firebase::auth::kAuthErrorNone) {
-      logMessage("Created new user successfully.");
-    } else {
-      logMessage("ERROR: User creation failed: %d, `%s`", error,
-                 sign_in_future_.error_message());
-    }
-    this->register_user_button_->setEnabled(true);
-    create_user_future_.Release();
+void FirebaseAuthScene::onCreateUserComplete(
+    const firebase::Future<firebase::auth::User*>& future) {
+  if (future.error() == firebase::auth::kAuthErrorNone) {
+    logMessage("Created new user successfully.");
+  } else {
+    FIREBASE_COCOS_LOG_ERROR(this, "User creation failed: %d, `%s`",
+                             future.error(), future.error_message());
   }
-  if (sign_in_future_.status() == firebase::kFutureStatusComplete) {
-    const AuthError error = static_cast<AuthError>(sign_in_future_.error());
-    if (error == firebase::auth::kAuthErrorNone) {
-      logMessage("Signed in successfully.");
-    } else {
-      logMessage("ERROR: Sign in failed: %d, `%s`", error,
-                 sign_in_future_.error_message());
-      if (this->anonymous_sign_in_) {
-        logMessage("You may need to enable anonymous login in the Firebase "
-                   "Console.");
-        logMessage("(In the console, navigate to Authentication > "
-                   "Sign-in Method > Anonymous and click Enable)");
-      }
-      this->credentialed_sign_in_button_->setEnabled(true);
-      this->anonymous_sign_in_button_->setEnabled(true);
-      this->sign_out_button_->setEnabled(false);
+  this->register_user_button_->setEnabled(true);
+}
+
+void FirebaseAuthScene::onSignInComplete(
+    const firebase::Future<firebase::auth::User*>& future) {
+  onSignInResult(future.error(), future.error_message());
+}
+
+void FirebaseAuthScene::onSignInResult(int error, const char* error_message) {
+  if (error == firebase::auth::kAuthErrorNone) {
+    logMessage("Signed in successfully.");
+  } else {
+    FIREBASE_COCOS_LOG_ERROR(this, "Sign in failed: %d, `%s`", error,
+                             error_message);
+    if (this->anonymous_sign_in_) {
+      logMessage("You may need to enable anonymous login in the Firebase "
+                 "Console.");
+      logMessage("(In the console, navigate to Authentication > "
+                 "Sign-in Method > Anonymous and click Enable)");
     }
-    sign_in_future_.Release();
+    this->credentialed_sign_in_button_->setEnabled(true);
+    this->anonymous_sign_in_button_->setEnabled(true);
+    this->sign_out_button_->setEnabled(false);
   }
 }
 
+// Futures are handled by completion callbacks, so there is nothing to poll and
+// the update is not scheduled.
+void FirebaseAuthScene::update(float /*delta*/) {}
+
 /// Handles the user tapping on the close app menu item.
 void FirebaseAuthScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Auth C++ resources.");
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
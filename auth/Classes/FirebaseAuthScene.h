@@ -41,6 +41,15 @@ class FirebaseAuthScene : public FirebaseScene {
 
   CREATE_FUNC(FirebaseAuthScene);
  private:
+  /// Called when the user created by the register user button is created.
+  void onCreateUserComplete(
+      const firebase::Future<firebase::auth::User*>& future);
+
+  /// Called when a sign in started by either sign in button completes. With
+  /// FIREBASE_COCOS_LOCAL_BACKEND anonymous sign in uses the local backend.
+  void onSignInComplete(const firebase::Future<firebase::auth::User*>& future);
+  void onSignInResult(int error, const char* error_message);
+
   /// A text field where a login email address may be entered.
   cocos2d::ui::TextField* email_text_field_;
 
@@ -59,13 +68,6 @@ class FirebaseAuthScene : public FirebaseScene {
   /// A button that logs the user out regardless of how they logged in.
   cocos2d::ui::Button* sign_out_button_;
 
-  /// A future that completes some time after attempting to create a new user.
-  firebase::Future<firebase::auth::User*> create_user_future_;
-
-  /// A future that completes some time after one of the login buttons is
-  /// pressed.
-  firebase::Future<firebase::auth::User*> sign_in_future_;
-
   /// Keeps track of whether or not the sign in attempt was made anonymously.
   bool anonymous_sign_in_;
 };
@@ -0,0 +1,283 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseBenchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "cocos2d.h"
+#include "ui/CocosGUI.h"
+#include "FirebaseMemoryTracker.h"
+#include "FirebaseScene.h"
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#define FIREBASE_COCOS_BENCHMARK_SUPPORTED 1
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+/// The scheduler key for the per-frame callback.
+static const char kScheduleKey[] = "FirebaseBenchmark";
+
+/// The press title that closes the sample and checks for leaks.
+static const char kClosePress[] = "close";
+
+/// Returns the steady clock time in nanoseconds.
+static uint64_t wallTime() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+/// Returns the CPU time used by the calling thread in nanoseconds.
+static uint64_t threadCpuTime() {
+#if FIREBASE_COCOS_BENCHMARK_SUPPORTED
+  struct timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL +
+         static_cast<uint64_t>(time.tv_nsec);
+#else
+  return 0;
+#endif
+}
+
+/// Returns the FirebaseScene layer under `node`, or null.
+static FirebaseScene* findSample(cocos2d::Node* node) {
+  FirebaseScene* sample = dynamic_cast<FirebaseScene*>(node);
+  if (sample) return sample;
+  for (cocos2d::Node* child : node->getChildren()) {
+    sample = findSample(child);
+    if (sample) return sample;
+  }
+  return nullptr;
+}
+
+/// Returns the first button titled `title` under `node`, or null.
+static cocos2d::ui::Button* findButton(cocos2d::Node* node,
+                                       const std::string& title) {
+  cocos2d::ui::Button* button = dynamic_cast<cocos2d::ui::Button*>(node);
+  if (button && button->getTitleText() == title) return button;
+  for (cocos2d::Node* child : node->getChildren()) {
+    button = findButton(child, title);
+    if (button) return button;
+  }
+  return nullptr;
+}
+
+FirebaseBenchmark* FirebaseBenchmark::createFromEnvironment() {
+#if FIREBASE_COCOS_BENCHMARK_SUPPORTED
+  const char* frames = getenv("FIREBASE_COCOS_BENCHMARK_FRAMES");
+  if (!frames || atoi(frames) <= 0) return nullptr;
+
+  // Parse "frame:title;frame:title".
+  std::vector<Press> presses;
+  const char* script = getenv("FIREBASE_COCOS_BENCHMARK_PRESSES");
+  std::string remaining = script ? script : "";
+  while (!remaining.empty()) {
+    const size_t end = remaining.find(';');
+    const std::string entry = remaining.substr(0, end);
+    remaining = end == std::string::npos ? "" : remaining.substr(end + 1);
+    const size_t colon = entry.find(':');
+    if (colon == std::string::npos) {
+      fprintf(stderr, "FirebaseBenchmark: ignoring press `%s`\n",
+              entry.c_str());
+      continue;
+    }
+    Press press;
+    press.frame = static_cast<uint32_t>(atoi(entry.substr(0, colon).c_str()));
+    press.title = entry.substr(colon + 1);
+    presses.push_back(press);
+  }
+  std::stable_sort(presses.begin(), presses.end(),
+                   [](const Press& a, const Press& b) {
+                     return a.frame < b.frame;
+                   });
+
+  const char* report = getenv("FIREBASE_COCOS_BENCHMARK_REPORT");
+  return new FirebaseBenchmark(static_cast<uint32_t>(atoi(frames)), presses,
+                               report ? report : "");
+#else
+  return nullptr;
+#endif
+}
+
+FirebaseBenchmark::FirebaseBenchmark(uint32_t frames,
+                                     const std::vector<Press>& presses,
+                                     const std::string& reportPath)
+    : frames_(frames),
+      presses_(presses),
+      reportPath_(reportPath),
+      nextPress_(0),
+      pressResults_(presses.size(), "not reached"),
+      frame_(0),
+      startWallTime_(0),
+      lastCpuTime_(0),
+      closed_(false) {
+  frameCpuTimes_.reserve(frames);
+}
+
+void FirebaseBenchmark::configure(cocos2d::GLView* glview) {
+#if FIREBASE_COCOS_BENCHMARK_SUPPORTED
+  // The window is still created, since the renderer needs its GL context, but
+  // it is never shown.
+  cocos2d::GLViewImpl* view = static_cast<cocos2d::GLViewImpl*>(glview);
+  glfwHideWindow(view->getWindow());
+  glfwSwapInterval(0);
+  // An interval of zero makes the main loop run frames back to back.
+  cocos2d::Director::getInstance()->setAnimationInterval(0);
+#else
+  (void)glview;
+#endif
+}
+
+void FirebaseBenchmark::start() {
+  startWallTime_ = wallTime();
+  lastCpuTime_ = threadCpuTime();
+  cocos2d::Director::getInstance()->getScheduler()->schedule(
+      [this](float /*delta*/) { onFrame(); }, this, 0, false, kScheduleKey);
+}
+
+void FirebaseBenchmark::onFrame() {
+  // The scheduler runs once per frame on the cocos thread, so the CPU time
+  // between calls covers a whole frame: update, draw and buffer swap.
+  const uint64_t cpuTime = threadCpuTime();
+  frameCpuTimes_.push_back(cpuTime - lastCpuTime_);
+  lastCpuTime_ = cpuTime;
+  ++frame_;
+
+  while (nextPress_ < presses_.size() &&
+         presses_[nextPress_].frame <= frame_) {
+    if (presses_[nextPress_].title == kClosePress) {
+      pressResults_[nextPress_] = closeSample();
+      ++nextPress_;
+      // Closing ends the director, so no further frames run.
+      if (closed_) {
+        finish();
+        return;
+      }
+      continue;
+    }
+    pressResults_[nextPress_] = press(presses_[nextPress_].title);
+    ++nextPress_;
+  }
+  if (frame_ >= frames_) finish();
+}
+
+const char* FirebaseBenchmark::press(const std::string& title) {
+  cocos2d::Director* director = cocos2d::Director::getInstance();
+  cocos2d::Scene* scene = director->getRunningScene();
+  cocos2d::ui::Button* button = scene ? findButton(scene, title) : nullptr;
+  if (!button) return "not found";
+  if (!button->isEnabled()) return "disabled";
+
+  // Tap the middle of the button by feeding the GL view the same screen
+  // coordinates a real touch would have.
+  const cocos2d::Size& size = button->getContentSize();
+  const cocos2d::Vec2 point = director->convertToUI(button->convertToWorldSpace(
+      cocos2d::Vec2(size.width / 2, size.height / 2)));
+  cocos2d::GLView* view = director->getOpenGLView();
+  const cocos2d::Rect& viewport = view->getViewPortRect();
+  intptr_t id = 0;
+  float x = point.x * view->getScaleX() + viewport.origin.x;
+  float y = point.y * view->getScaleY() + viewport.origin.y;
+  view->handleTouchesBegin(1, &id, &x, &y);
+  view->handleTouchesEnd(1, &id, &x, &y);
+  return "pressed";
+}
+
+const char* FirebaseBenchmark::closeSample() {
+  cocos2d::Scene* scene = cocos2d::Director::getInstance()->getRunningScene();
+  FirebaseScene* sample = scene ? findSample(scene) : nullptr;
+  if (!sample) return "not found";
+  sample->menuCloseAppCallback(nullptr);
+  closed_ = true;
+
+  // The scene's cleanup has run, so anything that must be released before
+  // close should already be gone.
+  FirebaseMemoryTracker::forEachType(
+      [this](const FirebaseMemoryTracker::TypeCount& type) {
+        const int live = type.live.load(std::memory_order_relaxed);
+        if (type.releaseBeforeClose && live > 0) {
+          Leak leak;
+          leak.name = type.name;
+          leak.live = live;
+          leaks_.push_back(leak);
+        }
+      });
+  return "pressed";
+}
+
+void FirebaseBenchmark::finish() {
+  const double seconds = (wallTime() - startWallTime_) / 1e9;
+  cocos2d::Director* director = cocos2d::Director::getInstance();
+  director->getScheduler()->unschedule(kScheduleKey, this);
+
+  std::vector<uint64_t> sorted(frameCpuTimes_);
+  std::sort(sorted.begin(), sorted.end());
+  uint64_t total = 0;
+  for (size_t i = 0; i < sorted.size(); ++i) total += sorted[i];
+  const size_t count = sorted.size();
+  const size_t p99Index = count - 1 - count / 100;
+
+  long peakRssKilobytes = 0;
+#if FIREBASE_COCOS_BENCHMARK_SUPPORTED
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) peakRssKilobytes = usage.ru_maxrss;
+#endif
+
+  FILE* file = reportPath_.empty() ? stdout : fopen(reportPath_.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "FirebaseBenchmark: could not open `%s`\n",
+            reportPath_.c_str());
+    file = stdout;
+  }
+  fprintf(file, "frames: %u\n", frame_);
+  fprintf(file, "seconds: %.3f\n", seconds);
+  fprintf(file, "fps: %.1f\n", seconds > 0 ? frame_ / seconds : 0.0);
+  fprintf(file, "frame_cpu_ms_mean: %.3f\n", total / 1e6 / count);
+  fprintf(file, "frame_cpu_ms_p50: %.3f\n", sorted[count / 2] / 1e6);
+  fprintf(file, "frame_cpu_ms_p99: %.3f\n", sorted[p99Index] / 1e6);
+  fprintf(file, "frame_cpu_ms_max: %.3f\n", sorted[count - 1] / 1e6);
+  fprintf(file, "peak_rss_kb: %ld\n", peakRssKilobytes);
+  for (size_t i = 0; i < presses_.size(); ++i) {
+    fprintf(file, "press: %u %s: %s\n", presses_[i].frame,
+            presses_[i].title.c_str(), pressResults_[i]);
+  }
+  if (closed_) {
+    fprintf(file, "leak_check: %s\n", leaks_.empty() ? "passed" : "failed");
+    for (size_t i = 0; i < leaks_.size(); ++i) {
+      fprintf(file, "live_at_close: %s %d\n", leaks_[i].name, leaks_[i].live);
+    }
+  }
+  if (file == stdout) {
+    fflush(file);
+  } else {
+    fclose(file);
+  }
+
+  // Let a script running the benchmark as a test see the leak.
+  if (!leaks_.empty()) exit(EXIT_FAILURE);
+  director->end();
+}
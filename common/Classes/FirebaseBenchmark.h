@@ -0,0 +1,123 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_BENCHMARK_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_BENCHMARK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace cocos2d {
+class GLView;
+}  // namespace cocos2d
+
+/// Runs the sample for a fixed number of frames as fast as it will go, taps
+/// buttons on a script, and reports the frame rate, the CPU time spent on each
+/// frame and the peak resident set size. Only supported on Linux.
+///
+/// The cocos2d-x renderer needs a GL context, so the benchmark hides the
+/// window rather than running without one. On a machine with no display or
+/// GPU, run it under Xvfb with Mesa's software renderer, for example:
+///
+///   export FIREBASE_COCOS_BENCHMARK_FRAMES=600
+///   export FIREBASE_COCOS_BENCHMARK_PRESSES="60:Query;120:Set"
+///   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./MyGame
+///
+/// The benchmark is configured by these environment variables:
+///   FIREBASE_COCOS_BENCHMARK_FRAMES  - The number of frames to run. The
+///                                      benchmark is off unless this is set.
+///   FIREBASE_COCOS_BENCHMARK_PRESSES - Buttons to tap, as `frame:title`
+///                                      pairs separated by semicolons.
+///   FIREBASE_COCOS_BENCHMARK_REPORT  - The file to write the report to.
+///                                      Defaults to standard output.
+///
+/// The title `close` taps the sample's close button and ends the benchmark
+/// there. It doubles as a leak check: any FirebaseMemoryTracker type that must
+/// be released before close and still has live objects is listed in the
+/// report, and the process exits with a failure status. For example:
+///
+///   export FIREBASE_COCOS_BENCHMARK_PRESSES="60:Add Listener;120:close"
+class FirebaseBenchmark {
+ public:
+  /// Returns the benchmark configured by the environment, or null if the
+  /// benchmark isn't enabled or the platform doesn't support it.
+  static FirebaseBenchmark* createFromEnvironment();
+
+  /// Hides the window, turns off vsync and uncaps the frame rate. Call once
+  /// the GL view has been created.
+  void configure(cocos2d::GLView* glview);
+
+  /// Starts counting frames. Call after the first scene is running. When the
+  /// last frame has run the report is written and the director is ended.
+  void start();
+
+ private:
+  /// A button to tap on a given frame.
+  struct Press {
+    uint32_t frame;
+    std::string title;
+  };
+
+  FirebaseBenchmark(uint32_t frames, const std::vector<Press>& presses,
+                    const std::string& reportPath);
+
+  /// Called once per frame by the scheduler.
+  void onFrame();
+
+  /// Taps the button titled `title` in the running scene, returning a short
+  /// description of what happened.
+  const char* press(const std::string& title);
+
+  /// Taps the running sample's close button and records the tracked objects
+  /// still alive that should have been released.
+  const char* closeSample();
+
+  /// Writes the report and ends the director.
+  void finish();
+
+  uint32_t frames_;
+  std::vector<Press> presses_;
+  std::string reportPath_;
+
+  /// The index of the next press in presses_, which is sorted by frame.
+  size_t nextPress_;
+  /// The outcome of each press, in the same order as presses_.
+  std::vector<const char*> pressResults_;
+
+  uint32_t frame_;
+  uint64_t startWallTime_;
+  uint64_t lastCpuTime_;
+  /// The thread CPU time, in nanoseconds, used by each frame.
+  std::vector<uint64_t> frameCpuTimes_;
+
+  /// A tracked type with objects left alive after the sample closed.
+  struct Leak {
+    const char* name;
+    int live;
+  };
+
+  /// Whether the sample was closed by a `close` press.
+  bool closed_;
+  std::vector<Leak> leaks_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_BENCHMARK_H_
@@ -0,0 +1,167 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseBinaryLog.h"
+
+#include <chrono>
+
+#if !defined(_WIN32)
+#define FIREBASE_COCOS_BINARY_LOG_SUPPORTED 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const char kMagic[8] = {'F', 'B', 'C', 'L', 'O', 'G', '0', '1'};
+static const uint32_t kVersion = 1;
+
+/// Returns the steady clock time in nanoseconds.
+static uint64_t steadyNanoseconds() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+FirebaseBinaryLog* FirebaseBinaryLog::open(const std::string& path,
+                                           size_t capacity) {
+#if FIREBASE_COCOS_BINARY_LOG_SUPPORTED
+  if (capacity <= kFileHeaderSize) return nullptr;
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return nullptr;
+  if (ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                    0);
+  // The mapping keeps the file open.
+  ::close(fd);
+  if (base == MAP_FAILED) return nullptr;
+
+  char* header = static_cast<char*>(base);
+  const uint32_t headerSize = kFileHeaderSize;
+  const uint64_t wallClock = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  const uint64_t steadyClock = steadyNanoseconds();
+  memcpy(header, kMagic, sizeof(kMagic));
+  memcpy(header + 8, &kVersion, sizeof(kVersion));
+  memcpy(header + 12, &headerSize, sizeof(headerSize));
+  memcpy(header + 16, &wallClock, sizeof(wallClock));
+  memcpy(header + 24, &steadyClock, sizeof(steadyClock));
+  return new FirebaseBinaryLog(path, static_cast<char*>(base), capacity);
+#else
+  (void)path;
+  (void)capacity;
+  return nullptr;
+#endif
+}
+
+FirebaseBinaryLog::FirebaseBinaryLog(const std::string& path, char* base,
+                                     size_t capacity)
+    : path_(path),
+      base_(base),
+      capacity_(capacity),
+      writeOffset_(kFileHeaderSize),
+      dropped_(0) {
+  for (size_t i = 0; i < kMaxFormats; ++i) {
+    formats_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+FirebaseBinaryLog::~FirebaseBinaryLog() {
+#if FIREBASE_COCOS_BINARY_LOG_SUPPORTED
+  msync(base_, capacity_, MS_SYNC);
+  munmap(base_, capacity_);
+#endif
+}
+
+void FirebaseBinaryLog::flush() {
+#if FIREBASE_COCOS_BINARY_LOG_SUPPORTED
+  msync(base_, capacity_, MS_ASYNC);
+#endif
+}
+
+uint32_t FirebaseBinaryLog::formatId(const char* format) {
+  // Open addressing on the string's address. Entries are never removed, so a
+  // null slot ends the search.
+  size_t index = (reinterpret_cast<uintptr_t>(format) >> 3) % kMaxFormats;
+  for (size_t probe = 0; probe < kMaxFormats; ++probe) {
+    std::atomic<const char*>& slot = formats_[index];
+    const char* existing = slot.load(std::memory_order_acquire);
+    if (existing == format) {
+      return static_cast<uint32_t>(index + 1);
+    }
+    if (existing == nullptr) {
+      if (slot.compare_exchange_strong(existing, format,
+                                       std::memory_order_acq_rel)) {
+        // This thread added the format, so it writes the definition. Another
+        // thread may write a message using the id first; the decoder reads
+        // all definitions before any messages.
+        const uint32_t id = static_cast<uint32_t>(index + 1);
+        const uint32_t length = static_cast<uint32_t>(strlen(format));
+        size_t size = kRecordHeaderSize + sizeof(length) + length;
+        char* record = reserve(&size);
+        if (record) {
+          memcpy(record + kRecordHeaderSize, &length, sizeof(length));
+          memcpy(record + kRecordHeaderSize + sizeof(length), format, length);
+          finishRecord(record, size, kDefinitionRecord, 0, id, 0);
+        }
+        return id;
+      }
+      if (existing == format) {
+        return static_cast<uint32_t>(index + 1);
+      }
+    }
+    index = (index + 1) % kMaxFormats;
+  }
+  return 0;
+}
+
+char* FirebaseBinaryLog::reserve(size_t* size) {
+  *size = (*size + 7) & ~static_cast<size_t>(7);
+  const size_t offset =
+      writeOffset_.fetch_add(*size, std::memory_order_relaxed);
+  if (offset + *size > capacity_ || offset + *size < offset) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  return base_ + offset;
+}
+
+void FirebaseBinaryLog::finishRecord(char* record, size_t size,
+                                     RecordType type, size_t argumentCount,
+                                     uint32_t formatId, int level) {
+  const uint16_t recordType = static_cast<uint16_t>(type);
+  const uint16_t count = static_cast<uint16_t>(argumentCount);
+  const uint32_t recordLevel = static_cast<uint32_t>(level);
+  const uint64_t timestamp = steadyNanoseconds();
+  memcpy(record + 4, &recordType, sizeof(recordType));
+  memcpy(record + 6, &count, sizeof(count));
+  memcpy(record + 8, &formatId, sizeof(formatId));
+  memcpy(record + 12, &recordLevel, sizeof(recordLevel));
+  memcpy(record + 16, &timestamp, sizeof(timestamp));
+  // The size goes in last; a record with no size yet reads as the end of the
+  // log.
+  const uint32_t recordSize = static_cast<uint32_t>(size);
+  memcpy(record, &recordSize, sizeof(recordSize));
+}
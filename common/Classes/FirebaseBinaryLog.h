@@ -0,0 +1,217 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_BINARY_LOG_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_BINARY_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+/// A compact binary log written to a memory-mapped file.
+///
+/// Instead of formatting text, each message record stores the id of its format
+/// string, a timestamp and the raw argument values. The first time a format
+/// string is seen a definition record mapping the id to the string is written
+/// as well. tools/decode_binary_log.py turns the file back into text.
+///
+/// Any thread may write. Space for each record is reserved with a single
+/// atomic add, so writers never block each other. Once the file is full,
+/// further records are dropped and counted.
+///
+/// The file is laid out as a 32 byte header followed by records, all little
+/// endian:
+///
+///   header:  char magic[8] = "FBCLOG01", uint32 version, uint32 headerSize,
+///            uint64 wall clock at open (ns since the epoch),
+///            uint64 steady clock at open (ns)
+///   record:  uint32 size (including padding to 8 bytes), uint16 type,
+///            uint16 argument count, uint32 format id, uint32 log level,
+///            uint64 steady clock (ns), payload
+///
+/// A definition record's payload is a uint32 length and the format string. A
+/// message record's payload is its arguments, each a one byte tag followed by
+/// an 8 byte value ('i' signed, 'u' unsigned, 'd' double, 'p' pointer) or, for
+/// 's', a uint32 length and the string's bytes.
+class FirebaseBinaryLog {
+ public:
+  /// Creates the log file at `path` with room for `capacity` bytes and maps
+  /// it into memory. Returns null if the file can't be created, or if memory
+  /// mapped files aren't supported on this platform.
+  static FirebaseBinaryLog* open(const std::string& path, size_t capacity);
+
+  ~FirebaseBinaryLog();
+
+  /// Writes a message record at log `level`. Safe to call from any thread.
+  template <typename... Args>
+  void write(int level, const char* format, const Args&... args);
+
+  /// Asks the OS to start writing the mapped file back to disk.
+  void flush();
+
+  /// Returns the number of records dropped since the last call because the
+  /// file was full, and resets the count.
+  size_t takeDroppedCount() {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+  /// The path of the log file.
+  const std::string& path() const { return path_; }
+
+ private:
+  enum RecordType { kDefinitionRecord = 1, kMessageRecord = 2 };
+
+  static const size_t kFileHeaderSize = 32;
+  static const size_t kRecordHeaderSize = 24;
+
+  /// The number of distinct format strings that can be given ids. Messages
+  /// with formats beyond that are written with id 0.
+  static const size_t kMaxFormats = 1024;
+
+  FirebaseBinaryLog(const std::string& path, char* base, size_t capacity);
+
+  /// Returns the id of `format`, writing its definition record the first time
+  /// it is seen.
+  uint32_t formatId(const char* format);
+
+  /// Reserves space for a record of `size` bytes, rounded up to a multiple of
+  /// 8. Returns null if the file is full.
+  char* reserve(size_t* size);
+
+  /// Fills in the header of a record whose payload has been written.
+  static void finishRecord(char* record, size_t size, RecordType type,
+                           size_t argumentCount, uint32_t formatId,
+                           int level);
+
+  // The encoded size of each supported argument type.
+  static size_t argumentSize(const char* value) {
+    return 1 + 4 + strlen(value ? value : "(null)");
+  }
+  template <typename T>
+  static size_t argumentSize(const T* /*value*/) {
+    return 9;
+  }
+  static size_t argumentSize(std::nullptr_t /*value*/) { return 9; }
+  template <typename T>
+  static typename std::enable_if<std::is_arithmetic<T>::value ||
+                                     std::is_enum<T>::value,
+                                 size_t>::type
+  argumentSize(T /*value*/) {
+    return 9;
+  }
+
+  static size_t argumentsSize() { return 0; }
+  template <typename First, typename... Rest>
+  static size_t argumentsSize(const First& first, const Rest&... rest) {
+    return argumentSize(first) + argumentsSize(rest...);
+  }
+
+  /// Writes a tag and a fixed size value.
+  template <typename T>
+  static void encodeValue(char** out, char tag, T value) {
+    static_assert(sizeof(T) == 8, "Binary log values are 8 bytes.");
+    **out = tag;
+    memcpy(*out + 1, &value, sizeof(value));
+    *out += 1 + sizeof(value);
+  }
+
+  // Encoders for each supported argument type.
+  static void encodeArgument(char** out, const char* value) {
+    // Match what printf prints for a null string.
+    if (!value) value = "(null)";
+    const uint32_t length = static_cast<uint32_t>(strlen(value));
+    **out = 's';
+    memcpy(*out + 1, &length, sizeof(length));
+    memcpy(*out + 5, value, length);
+    *out += 5 + length;
+  }
+  template <typename T>
+  static void encodeArgument(char** out, const T* value) {
+    encodeValue(out, 'p', static_cast<uint64_t>(
+                              reinterpret_cast<uintptr_t>(value)));
+  }
+  static void encodeArgument(char** out, std::nullptr_t /*value*/) {
+    encodeValue(out, 'p', static_cast<uint64_t>(0));
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type
+  encodeArgument(char** out, T value) {
+    encodeValue(out, 'd', static_cast<double>(value));
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value &&
+                                 std::is_signed<T>::value>::type
+  encodeArgument(char** out, T value) {
+    encodeValue(out, 'i', static_cast<int64_t>(value));
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value &&
+                                 !std::is_signed<T>::value>::type
+  encodeArgument(char** out, T value) {
+    encodeValue(out, 'u', static_cast<uint64_t>(value));
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_enum<T>::value>::type encodeArgument(
+      char** out, T value) {
+    encodeValue(out, 'i', static_cast<int64_t>(value));
+  }
+
+  static void encodeArguments(char** /*out*/) {}
+  template <typename First, typename... Rest>
+  static void encodeArguments(char** out, const First& first,
+                              const Rest&... rest) {
+    encodeArgument(out, first);
+    encodeArguments(out, rest...);
+  }
+
+  std::string path_;
+  char* base_;
+  size_t capacity_;
+
+  /// The offset the next record will be reserved at. Keeps growing once the
+  /// file is full, so it may be past the end of the file.
+  std::atomic<size_t> writeOffset_;
+
+  /// The number of records dropped because the file was full.
+  std::atomic<size_t> dropped_;
+
+  /// The format strings that have been given ids. A format's id is its index
+  /// plus one. Strings are compared by address, so each call site's literal
+  /// gets its own id.
+  std::atomic<const char*> formats_[kMaxFormats];
+};
+
+template <typename... Args>
+void FirebaseBinaryLog::write(int level, const char* format,
+                              const Args&... args) {
+  const uint32_t id = formatId(format);
+  size_t size = kRecordHeaderSize + argumentsSize(args...);
+  char* record = reserve(&size);
+  if (!record) return;
+  char* out = record + kRecordHeaderSize;
+  encodeArguments(&out, args...);
+  finishRecord(record, size, kMessageRecord, sizeof...(args), id, level);
+}
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_BINARY_LOG_H_
@@ -0,0 +1,135 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FirebaseChildCollection.h"
+
+#include <utility>
+
+FirebaseChildCollection::FirebaseChildCollection() : stats_() {}
+
+const char* FirebaseChildCollection::eventName(Event event) {
+  switch (event) {
+    case kChildAdded:
+      return "OnChildAdded";
+    case kChildChanged:
+      return "OnChildChanged";
+    case kChildMoved:
+      return "OnChildMoved";
+    case kChildRemoved:
+      return "OnChildRemoved";
+  }
+  return "";
+}
+
+void FirebaseChildCollection::apply(Event event, const char* key,
+                                    const firebase::Variant& value,
+                                    const char* previousKey) {
+  if (!key) return;
+  switch (event) {
+    case kChildAdded:
+      add(key, value, previousKey);
+      break;
+    case kChildChanged:
+      change(key, value);
+      break;
+    case kChildMoved:
+      move(key, previousKey);
+      break;
+    case kChildRemoved:
+      remove(key);
+      break;
+  }
+}
+
+void FirebaseChildCollection::add(const char* key,
+                                  const firebase::Variant& value,
+                                  const char* previousKey) {
+  std::unordered_map<std::string, iterator>::iterator found = index_.find(key);
+  if (found != index_.end()) {
+    found->second->value = value;
+    children_.splice(positionAfter(previousKey), children_, found->second);
+    ++stats_.changed;
+    return;
+  }
+  Child child;
+  child.key = key;
+  child.value = value;
+  const iterator inserted =
+      children_.insert(positionAfter(previousKey), std::move(child));
+  index_[inserted->key] = inserted;
+  ++stats_.added;
+}
+
+void FirebaseChildCollection::change(const char* key,
+                                     const firebase::Variant& value) {
+  std::unordered_map<std::string, iterator>::iterator found = index_.find(key);
+  if (found == index_.end()) {
+    Child child;
+    child.key = key;
+    child.value = value;
+    const iterator inserted =
+        children_.insert(children_.end(), std::move(child));
+    index_[inserted->key] = inserted;
+    ++stats_.added;
+    return;
+  }
+  found->second->value = value;
+  ++stats_.changed;
+}
+
+void FirebaseChildCollection::move(const char* key, const char* previousKey) {
+  std::unordered_map<std::string, iterator>::iterator found = index_.find(key);
+  if (found == index_.end()) return;
+  // Splicing a node to where it already is does nothing, so a child moved
+  // after itself stays put.
+  children_.splice(positionAfter(previousKey), children_, found->second);
+  ++stats_.moved;
+}
+
+void FirebaseChildCollection::remove(const char* key) {
+  std::unordered_map<std::string, iterator>::iterator found = index_.find(key);
+  if (found == index_.end()) return;
+  children_.erase(found->second);
+  index_.erase(found);
+  ++stats_.removed;
+}
+
+void FirebaseChildCollection::clear() {
+  children_.clear();
+  index_.clear();
+}
+
+const FirebaseChildCollection::Child* FirebaseChildCollection::find(
+    const char* key) const {
+  std::unordered_map<std::string, iterator>::const_iterator found =
+      index_.find(key);
+  return found == index_.end() ? nullptr : &*found->second;
+}
+
+FirebaseChildCollection::iterator FirebaseChildCollection::positionAfter(
+    const char* previousKey) {
+  if (!previousKey) return children_.begin();
+  std::unordered_map<std::string, iterator>::iterator found =
+      index_.find(previousKey);
+  if (found == index_.end()) return children_.end();
+  iterator position = found->second;
+  return ++position;
+}
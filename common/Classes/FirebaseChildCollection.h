@@ -0,0 +1,122 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_CHILD_COLLECTION_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_CHILD_COLLECTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "firebase/variant.h"
+
+/// A local copy of the children of a database path, kept in the server's
+/// order by applying the events of a ChildListener one at a time.
+///
+/// Each child is a node of a list, found by key through a hash index, so
+/// applying an event costs the same however many children there are: a large
+/// list that gains one child is sent and updated one child's worth, rather
+/// than as a new snapshot of the whole list.
+///
+/// An event's previous sibling key is the key of the child it follows, or
+/// null if it is first. Events that don't match the collection, such as a
+/// change to a child it doesn't have, are applied as the nearest event that
+/// does, so the copy recovers from a missed event.
+///
+/// Not thread safe; FirebaseChildSubscription guards it with its mutex.
+class FirebaseChildCollection {
+ public:
+  /// The ChildListener callbacks.
+  enum Event {
+    kChildAdded,
+    kChildChanged,
+    kChildMoved,
+    kChildRemoved,
+  };
+
+  struct Child {
+    std::string key;
+    firebase::Variant value;
+  };
+
+  typedef std::list<Child>::const_iterator const_iterator;
+
+  /// The number of events of each kind applied.
+  struct Stats {
+    uint64_t added;
+    uint64_t changed;
+    uint64_t moved;
+    uint64_t removed;
+  };
+
+  FirebaseChildCollection();
+
+  /// Returns the name of `event`, as the ChildListener callback.
+  static const char* eventName(Event event);
+
+  /// Applies `event` to the child `key`. `value` is ignored by moves, and
+  /// `previousKey` by changes and removals.
+  void apply(Event event, const char* key, const firebase::Variant& value,
+             const char* previousKey);
+
+  /// Adds the child `key` after `previousKey`. Adding a child that is already
+  /// there changes and moves it.
+  void add(const char* key, const firebase::Variant& value,
+           const char* previousKey);
+
+  /// Sets the value of the child `key`, which keeps its place. A child that
+  /// isn't there is added last.
+  void change(const char* key, const firebase::Variant& value);
+
+  /// Moves the child `key` after `previousKey`.
+  void move(const char* key, const char* previousKey);
+
+  /// Removes the child `key`.
+  void remove(const char* key);
+
+  /// Removes every child. The counters are kept.
+  void clear();
+
+  /// Returns the child `key`, or null.
+  const Child* find(const char* key) const;
+
+  size_t size() const { return children_.size(); }
+  const_iterator begin() const { return children_.begin(); }
+  const_iterator end() const { return children_.end(); }
+
+  Stats getStats() const { return stats_; }
+
+ private:
+  typedef std::list<Child>::iterator iterator;
+
+  /// Returns where a child following `previousKey` goes: after it, first if
+  /// it is null, or last if it isn't in the collection.
+  iterator positionAfter(const char* previousKey);
+
+  std::list<Child> children_;
+  std::unordered_map<std::string, iterator> index_;
+  Stats stats_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_CHILD_COLLECTION_H_
@@ -0,0 +1,189 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FirebaseChildSubscription.h"
+
+#include <memory>
+
+#include "cocos2d.h"
+#include "FirebaseLocalBackend.h"
+#include "FirebaseMemoryTracker.h"
+
+/// The ChildListener of a subscription.
+///
+/// Like FirebaseValueSubscriptions' listeners, it is disconnected when it is
+/// removed and deleted on a later frame, since a callback may already be
+/// running on an SDK thread.
+class FirebaseChildSubscription::Listener
+    : public firebase::database::ChildListener {
+ public:
+  explicit Listener(FirebaseChildSubscription* subscription)
+      : subscription_(subscription), attached_(new Attached) {}
+
+  // Each callback decodes only the child's snapshot.
+  void OnChildAdded(const firebase::database::DataSnapshot& snapshot,
+                    const char* previous_sibling_key) override {
+    deliverEvent(FirebaseChildCollection::kChildAdded, snapshot,
+                 previous_sibling_key);
+  }
+
+  void OnChildChanged(const firebase::database::DataSnapshot& snapshot,
+                      const char* previous_sibling_key) override {
+    deliverEvent(FirebaseChildCollection::kChildChanged, snapshot,
+                 previous_sibling_key);
+  }
+
+  void OnChildMoved(const firebase::database::DataSnapshot& snapshot,
+                    const char* previous_sibling_key) override {
+    deliverEvent(FirebaseChildCollection::kChildMoved, snapshot,
+                 previous_sibling_key);
+  }
+
+  void OnChildRemoved(
+      const firebase::database::DataSnapshot& snapshot) override {
+    deliverEvent(FirebaseChildCollection::kChildRemoved, snapshot, nullptr);
+  }
+
+  void OnCancelled(const firebase::database::Error& error,
+                   const char* error_message) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!subscription_) return;
+    subscription_->deliverCancelled(error, error_message);
+  }
+
+  /// Stops passing callbacks on. Once this returns no callback is using the
+  /// subscription, and the listener no longer counts as attached.
+  void disconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscription_ = nullptr;
+    attached_.reset();
+  }
+
+ private:
+  /// Counts the listeners added to the database and not yet removed.
+  struct Attached : FirebaseTracked<Attached, true> {
+    static const char* trackedName() { return "ChildListener"; }
+  };
+
+  void deliverEvent(FirebaseChildCollection::Event event,
+                    const firebase::database::DataSnapshot& snapshot,
+                    const char* previousKey) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!subscription_) return;
+    subscription_->deliverEvent(event, snapshot.key(), snapshot.value(),
+                                previousKey);
+  }
+
+  /// Held while a callback runs. Taken before the subscription's mutex.
+  std::mutex mutex_;
+  FirebaseChildSubscription* subscription_;
+  std::unique_ptr<Attached> attached_;
+};
+
+FirebaseChildSubscription::FirebaseChildSubscription()
+    : listener_(nullptr), localId_(0), active_(false) {}
+
+FirebaseChildSubscription::~FirebaseChildSubscription() { stop(); }
+
+void FirebaseChildSubscription::start(
+    firebase::database::Database* database, const std::string& path,
+    const EventCallback& onEvent, const CancelledCallback& onCancelled) {
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = true;
+    onEvent_ = onEvent;
+    onCancelled_ = onCancelled;
+  }
+  // The listener may be called before it is added, so mutex_ isn't held.
+  if (!database) {
+    localId_ = FirebaseLocalBackend::addChildListener(
+        path, [this](FirebaseChildCollection::Event event, const char* key,
+                     const firebase::Variant& value, const char* previousKey) {
+          deliverEvent(event, key, value, previousKey);
+        });
+    return;
+  }
+  reference_ = database->GetReference(path.c_str());
+  listener_ = new Listener(this);
+  reference_.AddChildListener(listener_);
+}
+
+void FirebaseChildSubscription::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) return;
+    active_ = false;
+  }
+  if (listener_) {
+    Listener* listener = listener_;
+    reference_.RemoveChildListener(listener);
+    listener->disconnect();
+    cocos2d::Director::getInstance()
+        ->getScheduler()
+        ->performFunctionInCocosThread([listener]() { delete listener; });
+    listener_ = nullptr;
+    reference_ = firebase::database::DatabaseReference();
+  } else if (localId_ != 0) {
+    FirebaseLocalBackend::removeChildListener(localId_);
+    localId_ = 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  children_.clear();
+  onEvent_ = EventCallback();
+  onCancelled_ = CancelledCallback();
+}
+
+void FirebaseChildSubscription::forEachChild(
+    const std::function<void(const char* key, const firebase::Variant& value)>&
+        visit) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (FirebaseChildCollection::const_iterator it = children_.begin();
+       it != children_.end(); ++it) {
+    visit(it->key.c_str(), it->value);
+  }
+}
+
+size_t FirebaseChildSubscription::getChildCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return children_.size();
+}
+
+FirebaseChildCollection::Stats FirebaseChildSubscription::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return children_.getStats();
+}
+
+void FirebaseChildSubscription::deliverEvent(
+    FirebaseChildCollection::Event event, const char* key,
+    const firebase::Variant& value, const char* previousKey) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!active_ || !key) return;
+  children_.apply(event, key, value, previousKey);
+  onEvent_(event, key, value, previousKey, children_.size());
+}
+
+void FirebaseChildSubscription::deliverCancelled(int error,
+                                                 const char* errorMessage) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!active_) return;
+  onCancelled_(error, errorMessage ? errorMessage : "");
+}
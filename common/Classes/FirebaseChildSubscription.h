@@ -0,0 +1,104 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_CHILD_SUBSCRIPTION_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_CHILD_SUBSCRIPTION_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "FirebaseChildCollection.h"
+#include "firebase/database.h"
+#include "firebase/variant.h"
+
+/// Listens to the children of a database path with a ChildListener and keeps
+/// a FirebaseChildCollection of them up to date, so each update is the one
+/// child that was added, changed, moved or removed rather than a snapshot of
+/// every child, as a ValueListener would get.
+///
+/// start() and stop() must be called on the cocos thread. The callbacks are
+/// called on the listener's thread, after the event has been applied to the
+/// collection, and never after stop() has returned; they must not start or
+/// stop the subscription.
+class FirebaseChildSubscription {
+ public:
+  /// Called with each event, the child it is for and the number of children
+  /// once it has been applied. `value` is the child's new value, or its old
+  /// value if it was removed. `previousKey` is the key of the child it now
+  /// follows, or null.
+  typedef std::function<void(FirebaseChildCollection::Event event,
+                             const char* key, const firebase::Variant& value,
+                             const char* previousKey, size_t childCount)>
+      EventCallback;
+
+  /// Called with the SDK error if the listener is cancelled.
+  typedef std::function<void(int error, const char* errorMessage)>
+      CancelledCallback;
+
+  FirebaseChildSubscription();
+
+  /// Stops the subscription.
+  ~FirebaseChildSubscription();
+
+  /// Starts listening to the children of `path`, through `database` or, if
+  /// it is null, FirebaseLocalBackend. Stops any previous subscription first.
+  void start(firebase::database::Database* database, const std::string& path,
+             const EventCallback& onEvent,
+             const CancelledCallback& onCancelled);
+
+  /// Removes the listener and empties the collection.
+  void stop();
+
+  /// Calls `visit` with each child, in order. `visit` must not start or stop
+  /// the subscription.
+  void forEachChild(const std::function<void(const char* key,
+                                             const firebase::Variant& value)>&
+                        visit) const;
+
+  size_t getChildCount() const;
+  FirebaseChildCollection::Stats getStats() const;
+
+ private:
+  class Listener;
+
+  /// Applies a listener callback and passes it on.
+  void deliverEvent(FirebaseChildCollection::Event event, const char* key,
+                    const firebase::Variant& value, const char* previousKey);
+  void deliverCancelled(int error, const char* errorMessage);
+
+  /// The listener, which is either a Listener on `reference_` or a
+  /// FirebaseLocalBackend listener. Only used on the cocos thread.
+  firebase::database::DatabaseReference reference_;
+  Listener* listener_;
+  int localId_;
+
+  /// Guards the members below, and is held while the callbacks are called.
+  mutable std::mutex mutex_;
+  bool active_;
+  FirebaseChildCollection children_;
+  EventCallback onEvent_;
+  CancelledCallback onCancelled_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_CHILD_SUBSCRIPTION_H_
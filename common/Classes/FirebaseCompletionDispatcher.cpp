@@ -0,0 +1,109 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FirebaseCompletionDispatcher.h"
+
+#include <vector>
+
+std::atomic<int> FirebaseCompletionDispatcher::pendingCount(0);
+std::mutex FirebaseCompletionDispatcher::mutex;
+std::unordered_map<FirebaseCompletionDispatcher::Operation,
+                   FirebaseCompletionDispatcher::Entry*>
+    FirebaseCompletionDispatcher::entries;
+FirebaseCompletionDispatcher::Operation
+    FirebaseCompletionDispatcher::nextOperation = 1;
+
+FirebaseCompletionDispatcher::Operation
+FirebaseCompletionDispatcher::beginOperation(cocos2d::Ref* owner) {
+  return add(owner, new Entry);
+}
+
+void FirebaseCompletionDispatcher::deliver(
+    Operation operation, const std::function<void()>& callback,
+    FirebaseTrace::Span delivery) {
+  cocos2d::Director::getInstance()
+      ->getScheduler()
+      ->performFunctionInCocosThread([operation, callback, delivery]() {
+        FirebaseTrace::Span delivered = delivery;
+        FirebaseTrace::end(&delivered);
+        Entry* entry = take(operation);
+        if (!entry) return;
+        callback();
+        finish(entry);
+      });
+}
+
+int FirebaseCompletionDispatcher::dropOwner(cocos2d::Ref* owner) {
+  std::vector<Entry*> dropped;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->second->owner == owner) {
+        dropped.push_back(it->second);
+        it = entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (Entry* entry : dropped) {
+    FirebaseTrace::end(&entry->span);
+    finish(entry);
+  }
+  return static_cast<int>(dropped.size());
+}
+
+FirebaseCompletionDispatcher::Operation FirebaseCompletionDispatcher::add(
+    cocos2d::Ref* owner, Entry* entry) {
+  entry->owner = owner;
+  owner->retain();
+  pendingCount.fetch_add(1, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex);
+  const Operation operation = nextOperation++;
+  entries[operation] = entry;
+  return operation;
+}
+
+bool FirebaseCompletionDispatcher::takeSpan(Operation operation,
+                                            FirebaseTrace::Span* span) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = entries.find(operation);
+  if (found == entries.end()) return false;
+  *span = found->second->span;
+  found->second->span = FirebaseTrace::Span();
+  return true;
+}
+
+FirebaseCompletionDispatcher::Entry* FirebaseCompletionDispatcher::take(
+    Operation operation) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = entries.find(operation);
+  if (found == entries.end()) return nullptr;
+  Entry* entry = found->second;
+  entries.erase(found);
+  return entry;
+}
+
+void FirebaseCompletionDispatcher::finish(Entry* entry) {
+  entry->owner->release();
+  delete entry;
+  pendingCount.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,179 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_COMPLETION_DISPATCHER_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_COMPLETION_DISPATCHER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+#include "cocos2d.h"
+#include "FirebaseMemoryTracker.h"
+#include "FirebaseReplay.h"
+#include "FirebaseTrace.h"
+#include "firebase/future.h"
+
+/// Delivers Future results to the cocos thread when they complete, so scenes
+/// don't have to poll status() every frame.
+///
+/// Each Future gets an OnCompletion callback that hands the finished Future
+/// to the scheduler's performFunctionInCocosThread queue, which the cocos
+/// thread drains once per frame. OnCompletion replaces any callback the
+/// Future already had, so a Future should be given to the dispatcher at most
+/// once and not also given its own OnCompletion callback.
+///
+/// Some Futures never complete, such as those of an ad deleted before its
+/// request finished, or one whose callback was replaced. A scene drops
+/// whatever it is still waiting for with dropOwner() when it closes, so
+/// those callbacks don't keep the scene or the pending count alive.
+class FirebaseCompletionDispatcher {
+ public:
+  /// The callback type for a Future<T>. Spelled this way so that T is deduced
+  /// from the Future alone and the callback may be a lambda.
+  template <typename T>
+  struct Callback {
+    typedef std::function<void(const firebase::Future<T>&)> Type;
+  };
+
+  /// Identifies a pending callback.
+  typedef uintptr_t Operation;
+
+  /// Calls `callback` on the cocos thread once `future` completes.
+  ///
+  /// `owner`, usually the scene the callback refers to, is retained until the
+  /// callback has run so the callback never outlives it. `span` is ended when
+  /// the Future completes, on whichever thread completes it, so the trace
+  /// shows the operation's own latency; the wait for the cocos thread is
+  /// traced as its delivery span.
+  template <typename T>
+  static void onCompletion(const firebase::Future<T>& future,
+                           cocos2d::Ref* owner,
+                           const typename Callback<T>::Type& callback,
+                           FirebaseTrace::Span span = FirebaseTrace::Span()) {
+    Pending<T>* pending = new Pending<T>;
+    pending->callback = callback;
+    pending->span = span;
+    const Operation operation = add(owner, pending);
+    // The Future is handed the operation rather than the entry, so one that
+    // completes after its entry was dropped finds nothing instead of freed
+    // memory. If the Future has already completed this calls completed()
+    // right away.
+    future.OnCompletion(completed<T>, reinterpret_cast<void*>(operation));
+  }
+
+  /// Counts an operation that has no Future, such as one run by
+  /// FirebaseLocalBackend, as pending, and retains `owner` until its result is
+  /// delivered with deliver().
+  static Operation beginOperation(cocos2d::Ref* owner);
+
+  /// Calls `callback` on the cocos thread, then releases the owner given to
+  /// beginOperation(). The callback doesn't run if the operation was dropped.
+  /// `delivery`, from FirebaseTrace::handOff(), is ended on the cocos thread.
+  /// May be called from any thread.
+  static void deliver(Operation operation,
+                      const std::function<void()>& callback,
+                      FirebaseTrace::Span delivery = FirebaseTrace::Span());
+
+  /// Drops every callback `owner` is still waiting for, releasing the owner
+  /// once for each. The callbacks never run, even if their Futures complete
+  /// later. Must be called on the cocos thread. Returns the number dropped.
+  static int dropOwner(cocos2d::Ref* owner);
+
+  /// Returns the number of Futures and operations whose callbacks haven't run
+  /// yet.
+  static int getPendingCount() {
+    return pendingCount.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /// The name pending callbacks are counted under by FirebaseMemoryTracker.
+  /// A scene's Futures should have completed by the time it closes.
+  struct PendingFuture {
+    static const char* trackedName() { return "pending Future"; }
+  };
+
+  /// A pending callback, owned by `entries` until it runs or is dropped.
+  struct Entry : FirebaseTracked<PendingFuture, true> {
+    virtual ~Entry() {}
+
+    cocos2d::Ref* owner;
+    FirebaseTrace::Span span;
+  };
+
+  template <typename T>
+  struct Pending : Entry {
+    typename Callback<T>::Type callback;
+  };
+
+  /// Retains `owner`, counts `entry` as pending and returns its operation.
+  static Operation add(cocos2d::Ref* owner, Entry* entry);
+
+  /// Moves the span of `operation` into `span`. Returns false if the
+  /// operation was dropped.
+  static bool takeSpan(Operation operation, FirebaseTrace::Span* span);
+
+  /// Removes the entry of `operation` and returns it, or returns null if the
+  /// operation was dropped.
+  static Entry* take(Operation operation);
+
+  /// Releases the owner of a removed entry and deletes it.
+  static void finish(Entry* entry);
+
+  /// The OnCompletion callback. Runs on the thread that completed the Future.
+  template <typename T>
+  static void completed(const firebase::Future<T>& future, void* userData) {
+    const Operation operation = reinterpret_cast<Operation>(userData);
+    FirebaseTrace::Span span;
+    if (!takeSpan(operation, &span)) return;
+    if (FirebaseReplay::isRecording()) {
+      const char* message = future.error_message();
+      FirebaseReplay::record(
+          FirebaseReplay::kFutureChannel,
+          {span.name ? span.name : "",
+           FirebaseReplay::formatInt(future.error()), message ? message : ""});
+    }
+    const FirebaseTrace::Span delivery = FirebaseTrace::handOff(&span);
+    // Copy the Future so the result outlives this callback.
+    firebase::Future<T> result(future);
+    cocos2d::Director::getInstance()
+        ->getScheduler()
+        ->performFunctionInCocosThread([operation, result, delivery]() {
+          FirebaseTrace::Span delivered = delivery;
+          FirebaseTrace::end(&delivered);
+          Pending<T>* pending = static_cast<Pending<T>*>(take(operation));
+          if (!pending) return;
+          pending->callback(result);
+          finish(pending);
+        });
+  }
+
+  static std::atomic<int> pendingCount;
+
+  /// Guards `entries` and `nextOperation`.
+  static std::mutex mutex;
+  static std::unordered_map<Operation, Entry*> entries;
+  static Operation nextOperation;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_COMPLETION_DISPATCHER_H_
@@ -0,0 +1,110 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseFramePacer.h"
+
+#include <atomic>
+
+#include "cocos2d.h"
+#include "FirebaseCompletionDispatcher.h"
+
+/// The frame rate while the app is idle.
+static const float kIdleFramesPerSecond = 5.0f;
+
+/// How long the app must be inactive before the frame rate is lowered. Long
+/// enough to cover a ScrollView's inertia after a drag.
+static const float kIdleDelaySeconds = 1.0f;
+
+/// The scheduler key for the per-frame callback.
+static const char kScheduleKey[] = "FirebaseFramePacer";
+
+/// The animation interval set before start(), used while the app is active.
+static float activeInterval = 0;
+
+/// Whether the idle frame rate is in effect.
+static bool idle = false;
+
+/// The seconds since the app was last active.
+static float inactiveSeconds = 0;
+
+/// The number of touches currently down.
+static int touchesDown = 0;
+
+/// Set by wake() on any thread and cleared by the next frame.
+static std::atomic<bool> woken(false);
+
+/// Listens to every touch without claiming it from the UI.
+static cocos2d::EventListenerTouchOneByOne* touchListener = nullptr;
+
+void FirebaseFramePacer::start() {
+  if (touchListener) return;
+  cocos2d::Director* director = cocos2d::Director::getInstance();
+  activeInterval = director->getAnimationInterval();
+
+  // A one-by-one listener that doesn't swallow sees each touch even when a
+  // button handles it. Its fixed priority runs it before the scene's
+  // listeners.
+  touchListener = cocos2d::EventListenerTouchOneByOne::create();
+  touchListener->setSwallowTouches(false);
+  touchListener->onTouchBegan = [](cocos2d::Touch*, cocos2d::Event*) {
+    ++touchesDown;
+    wake();
+    return true;
+  };
+  touchListener->onTouchMoved = [](cocos2d::Touch*, cocos2d::Event*) {
+    wake();
+  };
+  touchListener->onTouchEnded = [](cocos2d::Touch*, cocos2d::Event*) {
+    --touchesDown;
+    wake();
+  };
+  touchListener->onTouchCancelled = touchListener->onTouchEnded;
+  director->getEventDispatcher()->addEventListenerWithFixedPriority(
+      touchListener, -1);
+
+  director->getScheduler()->schedule(onFrame, touchListener, 0, false,
+                                     kScheduleKey);
+}
+
+void FirebaseFramePacer::wake() {
+  woken.store(true, std::memory_order_relaxed);
+}
+
+void FirebaseFramePacer::onFrame(float delta) {
+  cocos2d::Director* director = cocos2d::Director::getInstance();
+  const bool active =
+      woken.exchange(false, std::memory_order_relaxed) || touchesDown > 0 ||
+      FirebaseCompletionDispatcher::getPendingCount() > 0 ||
+      director->getActionManager()->getNumberOfRunningActions() > 0;
+  if (active) {
+    inactiveSeconds = 0;
+    if (idle) {
+      idle = false;
+      director->setAnimationInterval(activeInterval);
+    }
+    return;
+  }
+
+  inactiveSeconds += delta;
+  if (!idle && inactiveSeconds >= kIdleDelaySeconds) {
+    idle = true;
+    director->setAnimationInterval(1.0f / kIdleFramesPerSecond);
+  }
+}
@@ -0,0 +1,53 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_FRAME_PACER_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_FRAME_PACER_H_
+
+/// Lowers the frame rate while nothing on screen can change, and raises it
+/// again as soon as something might.
+///
+/// The sample scenes are static UI that only change when the user touches
+/// them, an action runs, or Firebase work completes and logs a line. While
+/// none of those has happened for a second the director runs at
+/// kIdleFramesPerSecond, which cuts idle CPU and GPU use; any of them puts it
+/// straight back to the full frame rate.
+///
+/// Going idle delays the response to the first touch or log line by up to one
+/// idle frame. Futures handed to FirebaseCompletionDispatcher keep the full
+/// frame rate until their callbacks have run.
+class FirebaseFramePacer {
+ public:
+  /// Starts pacing the director's frame rate. Must be called on the cocos
+  /// thread, after the director's animation interval has been set to the
+  /// full frame rate.
+  static void start();
+
+  /// Marks the app as active, so the next frame runs at the full frame rate.
+  /// Safe to call from any thread. Touches, running actions and pending
+  /// FirebaseCompletionDispatcher callbacks are noticed without calling this.
+  static void wake();
+
+ private:
+  /// Checks for activity once per frame and sets the animation interval.
+  static void onFrame(float delta);
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_FRAME_PACER_H_
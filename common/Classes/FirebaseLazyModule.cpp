@@ -0,0 +1,83 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseLazyModule.h"
+
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseTrace.h"
+
+FirebaseLazyModule::FirebaseLazyModule(const char* name,
+                                       Initializer initializer)
+    : name_(name),
+      initializer_(initializer),
+      state_(kStateUninitialized),
+      moduleInitializer_(nullptr) {}
+
+void FirebaseLazyModule::use(cocos2d::Ref* owner,
+                             const std::function<void()>& call) {
+  if (state_ == kStateInitialized) {
+    call();
+    return;
+  }
+
+  QueuedCall queued;
+  queued.owner = owner;
+  queued.call = call;
+  owner->retain();
+  queuedCalls_.push_back(queued);
+  if (state_ == kStateInitializing) return;
+
+  cocos2d::log("Initializing %s on first use.", name_);
+  state_ = kStateInitializing;
+  if (!moduleInitializer_) moduleInitializer_ = new firebase::ModuleInitializer;
+  moduleInitializer_->Initialize(firebase::App::GetInstance(), this,
+                                 initialize);
+  FirebaseCompletionDispatcher::onCompletion(
+      moduleInitializer_->InitializeLastResult(), owner,
+      CC_CALLBACK_1(FirebaseLazyModule::onInitializeComplete, this),
+      FirebaseTrace::begin(name_));
+}
+
+firebase::InitResult FirebaseLazyModule::initialize(firebase::App* app,
+                                                    void* context) {
+  return static_cast<FirebaseLazyModule*>(context)->initializer_(app);
+}
+
+void FirebaseLazyModule::onInitializeComplete(
+    const firebase::Future<void>& future) {
+  const bool initialized = future.error() == 0;
+  if (initialized) {
+    state_ = kStateInitialized;
+  } else {
+    cocos2d::log("Failed to initialize %s, dropping %d queued calls: %s",
+                 name_, static_cast<int>(queuedCalls_.size()),
+                 future.error_message());
+    state_ = kStateUninitialized;
+  }
+
+  // A replayed call may use() the module again, which runs straight away now
+  // that it is initialized, so take the queue before replaying it.
+  std::vector<QueuedCall> queuedCalls;
+  queuedCalls.swap(queuedCalls_);
+  for (size_t i = 0; i < queuedCalls.size(); ++i) {
+    if (initialized) queuedCalls[i].call();
+    queuedCalls[i].owner->release();
+  }
+}
@@ -0,0 +1,103 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_LAZY_MODULE_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_LAZY_MODULE_H_
+
+#include <functional>
+#include <vector>
+
+#include "cocos2d.h"
+#include "firebase/app.h"
+#include "firebase/future.h"
+#include "firebase/util.h"
+
+/// A Firebase module that is initialized the first time it is used rather
+/// than when its scene is created, so a session only pays for the modules it
+/// actually touches.
+///
+/// Declare one file-static FirebaseLazyModule per module and wrap each use of
+/// the module's API in use():
+///
+///     static FirebaseLazyModule analyticsModule("Analytics",
+///                                               initializeAnalytics);
+///     ...
+///     analyticsModule.use(this, []() { firebase::analytics::LogEvent(...); });
+///
+/// The first use() starts a firebase::ModuleInitializer, so on Android a
+/// missing Google Play services dependency is resolved before the module is
+/// used. Calls made while the module is initializing are queued and replayed
+/// in order once it is ready. If initialization fails the queued calls are
+/// dropped and the next use() tries again.
+///
+/// A module that must be running before its first API call, such as Cloud
+/// Messaging, whose listener receives the message that launched the app,
+/// should be initialized eagerly instead.
+///
+/// All methods must be called on the cocos thread.
+class FirebaseLazyModule {
+ public:
+  /// Initializes the module for `app`. Has the same contract as a
+  /// ModuleInitializer initializer: return kInitResultFailedMissingDependency
+  /// to have ModuleInitializer fix the dependency and call it again.
+  typedef firebase::InitResult (*Initializer)(firebase::App* app);
+
+  /// Creates the module. Nothing is initialized until the first use().
+  /// `name`, a string literal, is used for logging and tracing.
+  FirebaseLazyModule(const char* name, Initializer initializer);
+
+  /// Calls `call` once the module is initialized: right away if it already
+  /// is, otherwise after initialization completes. `owner`, usually the scene
+  /// the call refers to, is retained until the call has run or been dropped.
+  void use(cocos2d::Ref* owner, const std::function<void()>& call);
+
+  /// Returns true once the module has been initialized.
+  bool isInitialized() const { return state_ == kStateInitialized; }
+
+ private:
+  enum State {
+    kStateUninitialized,
+    kStateInitializing,
+    kStateInitialized,
+  };
+
+  /// A call queued while the module initializes.
+  struct QueuedCall {
+    cocos2d::Ref* owner;
+    std::function<void()> call;
+  };
+
+  /// The ModuleInitializer callback. `context` is the FirebaseLazyModule.
+  static firebase::InitResult initialize(firebase::App* app, void* context);
+
+  /// Replays or drops the queued calls once initialization completes.
+  void onInitializeComplete(const firebase::Future<void>& future);
+
+  const char* name_;
+  Initializer initializer_;
+  State state_;
+  std::vector<QueuedCall> queuedCalls_;
+
+  /// Created by the first use(). Modules are file-static and live as long as
+  /// the process, so this is never deleted.
+  firebase::ModuleInitializer* moduleInitializer_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_LAZY_MODULE_H_
@@ -0,0 +1,494 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FirebaseLocalBackend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "FirebaseCompletionDispatcher.h"
+#include "firebase/auth.h"
+#include "firebase/database.h"
+#include "firebase/storage.h"
+
+typedef std::chrono::steady_clock BackendClock;
+
+/// Fills in the result of a successful operation on the backend thread.
+typedef std::function<void(FirebaseLocalBackend::Result* result)>
+    BackendOperation;
+
+/// The message of injected errors.
+static const char kInjectedErrorMessage[] =
+    "Error injected by the local backend";
+
+/// An operation waiting for its completion time.
+struct BackendTask {
+  BackendClock::time_point due;
+  uint64_t sequence;
+  std::function<void()> run;
+};
+
+/// Orders the task queue so the earliest task is on top, and tasks due at
+/// the same time run in the order they were started.
+struct BackendTaskLater {
+  bool operator()(const BackendTask& a, const BackendTask& b) const {
+    return a.due != b.due ? a.due > b.due : a.sequence > b.sequence;
+  }
+};
+
+/// A value listener added with addValueListener().
+struct BackendListener {
+  int id;
+  std::string path;
+  FirebaseLocalBackend::ValueListener listener;
+};
+
+/// A child listener added with addChildListener().
+struct BackendChildListener {
+  int id;
+  std::string path;
+  FirebaseLocalBackend::ChildListener listener;
+};
+
+/// A write to a path, as the child listeners of its parent are told of it.
+struct BackendChildEvent {
+  std::string path;
+  FirebaseChildCollection::Event event;
+  /// The value written, or the old value of a removed path.
+  firebase::Variant value;
+};
+
+/// The state of the backend. It is never deleted, so the backend thread can
+/// keep using it while the process exits.
+struct LocalBackendState {
+  LocalBackendState()
+      : sequence(0),
+        started(false),
+        configured(false),
+        nextUserId(1),
+        nextListenerId(1) {}
+
+  /// The task queue and settings, guarded by `mutex`.
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::priority_queue<BackendTask, std::vector<BackendTask>, BackendTaskLater>
+      tasks;
+  uint64_t sequence;
+  bool started;
+  bool configured;
+  FirebaseLocalBackend::Config config;
+  std::mt19937 random;
+
+  /// The stored data. Only used by tasks, which all run on the backend
+  /// thread.
+  std::map<std::string, firebase::Variant> databaseValues;
+  std::map<std::string, std::string> storageBlobs;
+  uint64_t nextUserId;
+
+  /// The value and child listeners. `listenerMutex` is held while they are
+  /// called, so removing a listener waits for it to return.
+  std::mutex listenerMutex;
+  std::vector<BackendListener> listeners;
+  std::vector<BackendChildListener> childListeners;
+  int nextListenerId;
+};
+
+static LocalBackendState* backend = new LocalBackendState;
+
+/// Returns the last component of `path`, as DataSnapshot::key() does.
+static std::string pathKey(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/// Returns the path `path` is a child of, or an empty string if it has none.
+static std::string pathParent(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+/// Returns true if `path` is one level below `parent`.
+static bool isChildPath(const std::string& parent, const std::string& path) {
+  return path.size() > parent.size() + 1 &&
+         path.compare(0, parent.size(), parent) == 0 &&
+         path[parent.size()] == '/' &&
+         path.find('/', parent.size() + 1) == std::string::npos;
+}
+
+/// Reads the settings from the environment. Called with the mutex held.
+static void configureFromEnvironment() {
+  const char* latency = getenv("FIREBASE_COCOS_LOCAL_LATENCY_MS");
+  if (latency) {
+    backend->config.minLatencyMs = static_cast<uint32_t>(atoi(latency));
+    const char* colon = strchr(latency, ':');
+    backend->config.maxLatencyMs =
+        colon ? static_cast<uint32_t>(atoi(colon + 1))
+              : backend->config.minLatencyMs;
+  }
+  const char* errorRate = getenv("FIREBASE_COCOS_LOCAL_ERROR_RATE");
+  if (errorRate) backend->config.errorRate = atof(errorRate);
+  const char* seed = getenv("FIREBASE_COCOS_LOCAL_SEED");
+  if (seed) backend->config.seed = static_cast<uint32_t>(atoi(seed));
+  backend->random.seed(backend->config.seed);
+  backend->configured = true;
+}
+
+/// Runs tasks as they fall due. This is the backend thread.
+static void runBackend() {
+  std::unique_lock<std::mutex> lock(backend->mutex);
+  while (true) {
+    if (backend->tasks.empty()) {
+      backend->wake.wait(lock);
+      continue;
+    }
+    const BackendClock::time_point due = backend->tasks.top().due;
+    if (BackendClock::now() < due) {
+      backend->wake.wait_until(lock, due);
+      continue;
+    }
+    std::function<void()> run = backend->tasks.top().run;
+    backend->tasks.pop();
+    lock.unlock();
+    run();
+    lock.lock();
+  }
+}
+
+/// Queues `run` to be called on the backend thread after a random latency.
+/// It is passed true if the operation should fail with an injected error.
+static void scheduleTask(const std::function<void(bool fail)>& run) {
+  std::lock_guard<std::mutex> lock(backend->mutex);
+  if (!backend->configured) configureFromEnvironment();
+  if (!backend->started) {
+    backend->started = true;
+    std::thread(runBackend).detach();
+  }
+  const uint32_t maxLatency =
+      std::max(backend->config.minLatencyMs, backend->config.maxLatencyMs);
+  std::uniform_int_distribution<uint32_t> latency(backend->config.minLatencyMs,
+                                                  maxLatency);
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+  const bool fail = chance(backend->random) < backend->config.errorRate;
+
+  BackendTask task;
+  task.due = BackendClock::now() +
+             std::chrono::milliseconds(latency(backend->random));
+  task.sequence = backend->sequence++;
+  task.run = [run, fail]() { run(fail); };
+  backend->tasks.push(task);
+  backend->wake.notify_one();
+}
+
+/// Starts an operation whose result goes to `callback` on the cocos thread.
+/// `operate` fills in the result on the backend thread unless the operation
+/// fails, in which case the result has `injectedError`.
+static void startOperation(cocos2d::Ref* owner,
+                           const FirebaseLocalBackend::Callback& callback,
+                           FirebaseTrace::Span span, int injectedError,
+                           const BackendOperation& operate) {
+  const FirebaseCompletionDispatcher::Operation operation =
+      FirebaseCompletionDispatcher::beginOperation(owner);
+  scheduleTask([operation, callback, span, injectedError, operate](bool fail) {
+    FirebaseLocalBackend::Result result;
+    if (fail) {
+      result.error = injectedError;
+      result.errorMessage = kInjectedErrorMessage;
+    } else {
+      operate(&result);
+    }
+    FirebaseTrace::Span ended = span;
+    const FirebaseTrace::Span delivery = FirebaseTrace::handOff(&ended);
+    FirebaseCompletionDispatcher::deliver(
+        operation, [callback, result]() { callback(result); }, delivery);
+  });
+}
+
+/// Writes `value` to `path`, or deletes the path if `value` is null. Returns
+/// false if nothing changed, and otherwise sets `childEvent` to the event the
+/// child listeners of its parent are sent. Runs on the backend thread.
+static bool writeValue(const std::string& path, const firebase::Variant& value,
+                       BackendChildEvent* childEvent) {
+  auto found = backend->databaseValues.find(path);
+  childEvent->path = path;
+  if (value.is_null()) {
+    if (found == backend->databaseValues.end()) return false;
+    childEvent->event = FirebaseChildCollection::kChildRemoved;
+    childEvent->value = found->second;
+    backend->databaseValues.erase(found);
+    return true;
+  }
+  childEvent->event = found == backend->databaseValues.end()
+                          ? FirebaseChildCollection::kChildAdded
+                          : FirebaseChildCollection::kChildChanged;
+  childEvent->value = value;
+  backend->databaseValues[path] = value;
+  return true;
+}
+
+/// Sets `previousKey` to the key of the child of `parent` stored just before
+/// `path`, or returns false if there is none. Runs on the backend thread.
+static bool previousChildKey(const std::string& parent,
+                             const std::string& path,
+                             std::string* previousKey) {
+  const std::string prefix = parent + "/";
+  auto it = backend->databaseValues.lower_bound(path);
+  // The paths below `parent` are next to each other in the map.
+  while (it != backend->databaseValues.begin()) {
+    --it;
+    if (it->first.compare(0, prefix.size(), prefix) != 0) return false;
+    if (isChildPath(parent, it->first)) {
+      *previousKey = pathKey(it->first);
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Sends `childEvent` to the child listeners of its path's parent. Runs on
+/// the backend thread.
+static void callChildListeners(const BackendChildEvent& childEvent) {
+  const std::string parent = pathParent(childEvent.path);
+  const std::string key = pathKey(childEvent.path);
+  std::string previousKey;
+  const bool hasPrevious =
+      childEvent.event != FirebaseChildCollection::kChildRemoved &&
+      previousChildKey(parent, childEvent.path, &previousKey);
+  std::lock_guard<std::mutex> lock(backend->listenerMutex);
+  for (const BackendChildListener& entry : backend->childListeners) {
+    if (entry.path == parent) {
+      entry.listener(childEvent.event, key.c_str(), childEvent.value,
+                     hasPrevious ? previousKey.c_str() : nullptr);
+    }
+  }
+}
+
+/// Sends the child listener `id` a kChildAdded event for each child of
+/// `path`, in order. Runs on the backend thread.
+static void sendChildren(const std::string& path, int id) {
+  const std::string prefix = path + "/";
+  std::lock_guard<std::mutex> lock(backend->listenerMutex);
+  for (const BackendChildListener& entry : backend->childListeners) {
+    if (entry.id != id) continue;
+    std::string previousKey;
+    bool hasPrevious = false;
+    for (auto it = backend->databaseValues.lower_bound(prefix);
+         it != backend->databaseValues.end() &&
+         it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+      if (!isChildPath(path, it->first)) continue;
+      const std::string key = pathKey(it->first);
+      entry.listener(FirebaseChildCollection::kChildAdded, key.c_str(),
+                     it->second, hasPrevious ? previousKey.c_str() : nullptr);
+      previousKey = key;
+      hasPrevious = true;
+    }
+    return;
+  }
+}
+
+/// Calls the listeners of `path`, or only the listener `id` if it isn't 0.
+/// Runs on the backend thread.
+static void callListeners(const std::string& path, int id) {
+  auto found = backend->databaseValues.find(path);
+  const firebase::Variant value = found == backend->databaseValues.end()
+                                      ? firebase::Variant::Null()
+                                      : found->second;
+  const std::string key = pathKey(path);
+  std::lock_guard<std::mutex> lock(backend->listenerMutex);
+  for (const BackendListener& entry : backend->listeners) {
+    if (entry.path == path && (id == 0 || entry.id == id)) {
+      entry.listener(key.c_str(), value);
+    }
+  }
+}
+
+void FirebaseLocalBackend::configure(const Config& config) {
+  std::lock_guard<std::mutex> lock(backend->mutex);
+  backend->config = config;
+  backend->random.seed(config.seed);
+  backend->configured = true;
+}
+
+void FirebaseLocalBackend::signInAnonymously(cocos2d::Ref* owner,
+                                             const Callback& callback,
+                                             FirebaseTrace::Span span) {
+  startOperation(owner, callback, span,
+                 firebase::auth::kAuthErrorNetworkRequestFailed,
+                 [](Result* result) {
+                   char userId[32];
+                   snprintf(
+                       userId, sizeof(userId), "local-user-%llu",
+                       static_cast<unsigned long long>(backend->nextUserId++));
+                   result->value = firebase::Variant::FromMutableString(userId);
+                 });
+}
+
+void FirebaseLocalBackend::getValue(const std::string& path,
+                                    cocos2d::Ref* owner,
+                                    const Callback& callback,
+                                    FirebaseTrace::Span span) {
+  startOperation(owner, callback, span, firebase::database::kErrorNetworkError,
+                 [path](Result* result) {
+                   auto found = backend->databaseValues.find(path);
+                   if (found != backend->databaseValues.end()) {
+                     result->value = found->second;
+                   }
+                 });
+}
+
+void FirebaseLocalBackend::setValue(const std::string& path,
+                                    const firebase::Variant& value,
+                                    cocos2d::Ref* owner,
+                                    const Callback& callback,
+                                    FirebaseTrace::Span span) {
+  startOperation(owner, callback, span, firebase::database::kErrorNetworkError,
+                 [path, value](Result* /*result*/) {
+                   BackendChildEvent childEvent;
+                   const bool changed = writeValue(path, value, &childEvent);
+                   callListeners(path, 0);
+                   if (changed) callChildListeners(childEvent);
+                 });
+}
+
+void FirebaseLocalBackend::updateChildren(
+    const std::string& path,
+    const std::map<std::string, firebase::Variant>& values,
+    cocos2d::Ref* owner, const Callback& callback, FirebaseTrace::Span span) {
+  startOperation(owner, callback, span, firebase::database::kErrorNetworkError,
+                 [path, values](Result* /*result*/) {
+                   // Write every value before any listener sees the update.
+                   std::vector<BackendChildEvent> childEvents;
+                   for (const auto& child : values) {
+                     BackendChildEvent childEvent;
+                     if (writeValue(path + "/" + child.first, child.second,
+                                    &childEvent)) {
+                       childEvents.push_back(childEvent);
+                     }
+                   }
+                   for (const auto& child : values) {
+                     callListeners(path + "/" + child.first, 0);
+                   }
+                   // The events are in key order, so each one's previous
+                   // sibling has already been sent.
+                   for (const BackendChildEvent& childEvent : childEvents) {
+                     callChildListeners(childEvent);
+                   }
+                 });
+}
+
+int FirebaseLocalBackend::addValueListener(const std::string& path,
+                                           const ValueListener& listener) {
+  int id;
+  {
+    std::lock_guard<std::mutex> lock(backend->listenerMutex);
+    id = backend->nextListenerId++;
+    BackendListener entry;
+    entry.id = id;
+    entry.path = path;
+    entry.listener = listener;
+    backend->listeners.push_back(entry);
+  }
+  // Like the SDK, send the current value once the listener is registered. A
+  // listener isn't sent injected errors.
+  scheduleTask([path, id](bool /*fail*/) { callListeners(path, id); });
+  return id;
+}
+
+void FirebaseLocalBackend::removeValueListener(int id) {
+  std::lock_guard<std::mutex> lock(backend->listenerMutex);
+  std::vector<BackendListener>& listeners = backend->listeners;
+  for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+    if (it->id == id) {
+      listeners.erase(it);
+      return;
+    }
+  }
+}
+
+int FirebaseLocalBackend::addChildListener(const std::string& path,
+                                           const ChildListener& listener) {
+  int id;
+  {
+    std::lock_guard<std::mutex> lock(backend->listenerMutex);
+    id = backend->nextListenerId++;
+    BackendChildListener entry;
+    entry.id = id;
+    entry.path = path;
+    entry.listener = listener;
+    backend->childListeners.push_back(entry);
+  }
+  // Like the SDK, send the existing children once the listener is registered.
+  scheduleTask([path, id](bool /*fail*/) { sendChildren(path, id); });
+  return id;
+}
+
+void FirebaseLocalBackend::removeChildListener(int id) {
+  std::lock_guard<std::mutex> lock(backend->listenerMutex);
+  std::vector<BackendChildListener>& listeners = backend->childListeners;
+  for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+    if (it->id == id) {
+      listeners.erase(it);
+      return;
+    }
+  }
+}
+
+void FirebaseLocalBackend::getBytes(const std::string& path,
+                                    cocos2d::Ref* owner,
+                                    const Callback& callback,
+                                    FirebaseTrace::Span span) {
+  startOperation(owner, callback, span, firebase::storage::kErrorUnknown,
+                 [path](Result* result) {
+                   auto found = backend->storageBlobs.find(path);
+                   if (found == backend->storageBlobs.end()) {
+                     result->error = firebase::storage::kErrorObjectNotFound;
+                     result->errorMessage = "Object does not exist";
+                     return;
+                   }
+                   result->bytes = found->second;
+                 });
+}
+
+void FirebaseLocalBackend::putBytes(const std::string& path, const void* data,
+                                    size_t size, cocos2d::Ref* owner,
+                                    const Callback& callback,
+                                    FirebaseTrace::Span span) {
+  // Copy the bytes now, so the caller's buffer may change while the write is
+  // in flight.
+  const std::string bytes(static_cast<const char*>(data), size);
+  startOperation(owner, callback, span, firebase::storage::kErrorUnknown,
+                 [path, bytes](Result* result) {
+                   backend->storageBlobs[path] = bytes;
+                   result->value = firebase::Variant::FromInt64(
+                       static_cast<int64_t>(bytes.size()));
+                 });
+}
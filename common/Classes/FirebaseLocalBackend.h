@@ -0,0 +1,158 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_LOCAL_BACKEND_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_LOCAL_BACKEND_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "cocos2d.h"
+#include "FirebaseChildCollection.h"
+#include "FirebaseTrace.h"
+#include "firebase/variant.h"
+
+/// An in-process stand-in for the Auth, Realtime Database and Storage
+/// services, so the scenes' Firebase code paths can be load tested offline.
+/// On Linux desktop the Firebase C++ APIs are stubs; scenes built with
+/// FIREBASE_COCOS_LOCAL_BACKEND defined send their anonymous sign in, database
+/// and storage operations here instead.
+///
+/// The database maps paths to scalar Variants and storage maps paths to bytes.
+/// Writing null to a path deletes it. The children of a path are the paths
+/// one level below it, ordered by key.
+/// Both are in memory and shared by every scene. Each operation completes
+/// after a random latency and fails with the given probability, as set by
+/// configure() or, until it is called, by these environment variables:
+///
+///   FIREBASE_COCOS_LOCAL_LATENCY_MS  "min:max" latency in ms, default 20:100
+///   FIREBASE_COCOS_LOCAL_ERROR_RATE  fraction of operations that fail, 0
+///   FIREBASE_COCOS_LOCAL_SEED        random seed, for repeatable runs, 1
+///
+/// Operations run on one backend thread in order of completion time, so any
+/// number may be in flight. Their callbacks run on the cocos thread through
+/// FirebaseCompletionDispatcher, which retains `owner` until then as
+/// onCompletion() does, and `span` ends when the operation completes. Value
+/// and child listeners are called on the backend thread, as the SDK calls
+/// them on its own threads.
+class FirebaseLocalBackend {
+ public:
+  /// The latency and error injection settings.
+  struct Config {
+    Config() : minLatencyMs(20), maxLatencyMs(100), errorRate(0), seed(1) {}
+
+    uint32_t minLatencyMs;
+    uint32_t maxLatencyMs;
+    double errorRate;
+    uint32_t seed;
+  };
+
+  /// The outcome of an operation. `error` is the error code the SDK would
+  /// have given, and 0 on success.
+  struct Result {
+    Result() : error(0) {}
+
+    int error;
+    std::string errorMessage;
+
+    /// The value read by getValue(), the user id from signInAnonymously() or
+    /// the number of bytes written by putBytes().
+    firebase::Variant value;
+
+    /// The bytes read by getBytes().
+    std::string bytes;
+  };
+
+  typedef std::function<void(const Result& result)> Callback;
+
+  /// Called with the key and value of a listened to path.
+  typedef std::function<void(const char* key, const firebase::Variant& value)>
+      ValueListener;
+
+  /// Called with a child event of a listened to path: the child's key, its
+  /// value (the old value for a removal) and the key of the child before it,
+  /// or null if it is first. Children are ordered by key, so they are never
+  /// moved.
+  typedef std::function<void(FirebaseChildCollection::Event event,
+                             const char* key, const firebase::Variant& value,
+                             const char* previousKey)>
+      ChildListener;
+
+  /// Sets the latency and error injection. Operations already in flight keep
+  /// their settings.
+  static void configure(const Config& config);
+
+  /// Signs in a new anonymous user.
+  static void signInAnonymously(cocos2d::Ref* owner, const Callback& callback,
+                                FirebaseTrace::Span span);
+
+  /// Reads the value at `path`, which is null if nothing was written there.
+  static void getValue(const std::string& path, cocos2d::Ref* owner,
+                       const Callback& callback, FirebaseTrace::Span span);
+
+  /// Writes `value` to `path` and calls the path's value listeners and its
+  /// parent's child listeners.
+  static void setValue(const std::string& path, const firebase::Variant& value,
+                       cocos2d::Ref* owner, const Callback& callback,
+                       FirebaseTrace::Span span);
+
+  /// Writes each of `values`, keyed by path relative to `path`, in a single
+  /// operation, as UpdateChildren does, then calls their value and child
+  /// listeners.
+  static void updateChildren(
+      const std::string& path,
+      const std::map<std::string, firebase::Variant>& values,
+      cocos2d::Ref* owner, const Callback& callback, FirebaseTrace::Span span);
+
+  /// Calls `listener` with the value at `path` once, after the operation
+  /// latency, and again each time it is written. Returns the listener's id.
+  static int addValueListener(const std::string& path,
+                              const ValueListener& listener);
+
+  /// Removes a value listener. Once this returns it is not running and will
+  /// not be called again.
+  static void removeValueListener(int id);
+
+  /// Calls `listener` with a kChildAdded event for each child of `path`, in
+  /// order, after the operation latency, and then with each change to its
+  /// children. Returns the listener's id.
+  static int addChildListener(const std::string& path,
+                              const ChildListener& listener);
+
+  /// Removes a child listener. Once this returns it is not running and will
+  /// not be called again.
+  static void removeChildListener(int id);
+
+  /// Reads the bytes stored at `path`.
+  static void getBytes(const std::string& path, cocos2d::Ref* owner,
+                       const Callback& callback, FirebaseTrace::Span span);
+
+  /// Stores `size` bytes from `data` at `path`.
+  static void putBytes(const std::string& path, const void* data, size_t size,
+                       cocos2d::Ref* owner, const Callback& callback,
+                       FirebaseTrace::Span span);
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_LOCAL_BACKEND_H_
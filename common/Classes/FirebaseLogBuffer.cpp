@@ -0,0 +1,96 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseLogBuffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+FirebaseLogBuffer::FirebaseLogBuffer(size_t maxLines, size_t maxBytes)
+    : lines_(std::max<size_t>(maxLines, 1)),
+      firstLine_(0),
+      lineCount_(0),
+      evictedLines_(0),
+      bytes_(std::max<size_t>(maxBytes, 2)),
+      writeOffset_(0) {}
+
+void FirebaseLogBuffer::append(const char* text, size_t length) {
+  const size_t capacity = bytes_.size();
+  // Leave room for the terminator.
+  length = std::min(length, capacity - 1);
+  const size_t size = length + 1;
+
+  if (lineCount_ == lines_.size()) {
+    evictOldest();
+  }
+  if (writeOffset_ + size > capacity) {
+    // There isn't room before the end of the arena, so wrap around to the
+    // start. Any lines still stored past the write offset are the oldest ones
+    // and are dropped along with the unused tail.
+    while (lineCount_ > 0 && lineAt(0).offset >= writeOffset_) {
+      evictOldest();
+    }
+    writeOffset_ = 0;
+  }
+  // Evict the oldest lines until the new line no longer overlaps them.
+  while (lineCount_ > 0) {
+    const Line& oldest = lineAt(0);
+    if (oldest.offset >= writeOffset_ + size ||
+        oldest.offset + oldest.length + 1 <= writeOffset_) {
+      break;
+    }
+    evictOldest();
+  }
+  if (lineCount_ == 0) {
+    writeOffset_ = 0;
+  }
+
+  memcpy(&bytes_[writeOffset_], text, length);
+  bytes_[writeOffset_ + length] = '\0';
+  Line& line = lines_[(firstLine_ + lineCount_) % lines_.size()];
+  line.offset = writeOffset_;
+  line.length = length;
+  ++lineCount_;
+  writeOffset_ += size;
+}
+
+void FirebaseLogBuffer::clear() {
+  firstLine_ = 0;
+  lineCount_ = 0;
+  evictedLines_ = 0;
+  writeOffset_ = 0;
+}
+
+const char* FirebaseLogBuffer::line(size_t index, size_t* length) const {
+  if (index >= lineCount_) {
+    if (length) *length = 0;
+    return "";
+  }
+  const Line& line = lineAt(index);
+  if (length) *length = line.length;
+  return &bytes_[line.offset];
+}
+
+void FirebaseLogBuffer::evictOldest() {
+  firstLine_ = (firstLine_ + 1) % lines_.size();
+  --lineCount_;
+  ++evictedLines_;
+}
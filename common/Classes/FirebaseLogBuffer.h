@@ -0,0 +1,92 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_LOG_BUFFER_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_LOG_BUFFER_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+/// A fixed-capacity ring buffer of log lines.
+///
+/// All storage is allocated up front: a table of line records and a byte arena
+/// the lines are copied into. Once either the line or the byte budget is
+/// exhausted the oldest lines are evicted, so appending a line costs the same
+/// no matter how long the app has been running.
+///
+/// This class is not thread-safe.
+class FirebaseLogBuffer {
+ public:
+  /// Creates a buffer that holds at most `maxLines` lines and `maxBytes` bytes
+  /// of text (including one terminator per line).
+  FirebaseLogBuffer(size_t maxLines, size_t maxBytes);
+
+  /// Appends a line of text, evicting the oldest lines as needed. Lines longer
+  /// than the byte budget are truncated.
+  void append(const char* text, size_t length);
+
+  /// Removes all lines from the buffer.
+  void clear();
+
+  /// The number of lines currently held.
+  size_t lineCount() const { return lineCount_; }
+
+  /// The maximum number of lines the buffer can hold.
+  size_t maxLines() const { return lines_.size(); }
+
+  /// The number of lines evicted since the buffer was created or cleared.
+  /// Adding this to a line's index gives a number that identifies the line
+  /// for as long as it is held.
+  size_t firstLineNumber() const { return evictedLines_; }
+
+  /// Returns the null-terminated line at `index`, where 0 is the oldest line
+  /// still held. If `length` is non-null it is set to the line's length.
+  const char* line(size_t index, size_t* length) const;
+
+ private:
+  /// The location of a line in the byte arena.
+  struct Line {
+    size_t offset;
+    size_t length;
+  };
+
+  /// Drops the oldest line.
+  void evictOldest();
+
+  /// Returns the record for the line at `index`, where 0 is the oldest line.
+  const Line& lineAt(size_t index) const {
+    return lines_[(firstLine_ + index) % lines_.size()];
+  }
+
+  /// A ring of line records, `lineCount_` of which are live starting at
+  /// `firstLine_`.
+  std::vector<Line> lines_;
+  size_t firstLine_;
+  size_t lineCount_;
+  size_t evictedLines_;
+
+  /// The byte arena. Every line is stored contiguously and null-terminated,
+  /// with new lines written at `writeOffset_`.
+  std::vector<char> bytes_;
+  size_t writeOffset_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_LOG_BUFFER_H_
@@ -0,0 +1,90 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseLogQueue.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+/// Rounds `value` up to the next power of two.
+static size_t roundUpToPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+FirebaseLogQueue::FirebaseLogQueue(size_t capacity)
+    : slots_(new Slot[roundUpToPowerOfTwo(capacity)]),
+      mask_(roundUpToPowerOfTwo(capacity) - 1),
+      scratch_(new char[(mask_ + 1) * kSlotTextSize]),
+      enqueuePosition_(0),
+      dequeuePosition_(0),
+      dropped_(0) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool FirebaseLogQueue::push(const char* text, size_t length) {
+  length = std::min(length, maxRecordLength());
+  const size_t span =
+      std::max<size_t>((length + kSlotTextSize - 1) / kSlotTextSize, 1);
+  size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+  for (;;) {
+    // The consumer frees slots in order, so once the last slot of the run is
+    // free for this lap the ones before it are too.
+    const Slot& last = slots_[(position + span - 1) & mask_];
+    const size_t sequence = last.sequence.load(std::memory_order_acquire);
+    const intptr_t difference = static_cast<intptr_t>(sequence) -
+                                static_cast<intptr_t>(position + span - 1);
+    if (difference == 0) {
+      // The slots are free; try to claim them.
+      if (enqueuePosition_.compare_exchange_weak(position, position + span,
+                                                 std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // The consumer hasn't freed the slots yet, so the queue is full.
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      // Another producer claimed the slots first.
+      position = enqueuePosition_.load(std::memory_order_relaxed);
+    }
+  }
+  Slot& first = slots_[position & mask_];
+  first.length = static_cast<uint32_t>(length);
+  first.span = static_cast<uint32_t>(span);
+  // Fill and publish the trailing slots, then the first one, which is the
+  // only slot the consumer waits on.
+  for (size_t i = span; i-- > 0;) {
+    Slot& slot = slots_[(position + i) & mask_];
+    const size_t offset = i * kSlotTextSize;
+    memcpy(slot.text, text + offset,
+           std::min(length - offset, kSlotTextSize));
+    if (i != 0) {
+      slot.sequence.store(position + i + 1, std::memory_order_release);
+    }
+  }
+  first.sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,138 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_LOG_QUEUE_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_LOG_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <memory>
+
+/// A bounded, lock-free queue of preformatted log records.
+///
+/// Any number of threads may push records (Firebase invokes listeners and
+/// completion callbacks on its own threads), while a single consumer, the
+/// Cocos2d thread, drains them. Pushing never blocks: if the queue is full the
+/// record is dropped and counted instead. Records are copied into slots owned
+/// by the queue, so no strings are shared between threads.
+///
+/// A record longer than one slot is stored in a run of consecutive slots that
+/// the producer claims all at once, so long records are never interleaved with
+/// records from other threads.
+class FirebaseLogQueue {
+ public:
+  /// The number of bytes of text that fit in a single slot.
+  static const size_t kSlotTextSize = 112;
+
+  /// Creates a queue with `capacity` slots. The capacity is rounded up to a
+  /// power of two.
+  explicit FirebaseLogQueue(size_t capacity);
+
+  /// The longest record the queue can hold.
+  size_t maxRecordLength() const { return (mask_ + 1) * kSlotTextSize; }
+
+  /// Copies a record into the queue. Safe to call from any thread. Returns
+  /// false if the queue was full and the record was dropped. Text longer than
+  /// maxRecordLength() is truncated.
+  bool push(const char* text, size_t length);
+
+  /// Passes each queued record to `consume(const char* text, size_t length)`,
+  /// oldest first, and returns the number of records consumed. The text is not
+  /// null-terminated. Must only be called from the consumer thread.
+  template <typename Consumer>
+  size_t drain(Consumer consume);
+
+  /// Returns the number of records dropped since the last call, and resets the
+  /// count. Must only be called from the consumer thread.
+  size_t takeDroppedCount() {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+ private:
+  /// One slot of a record. `sequence` says whether the slot is free for the
+  /// producer at position `sequence`, or holds data for position
+  /// `sequence - 1` ready for the consumer. The first slot of a record holds
+  /// the record's total length and the number of slots it spans, and is
+  /// published after the rest of the record's slots.
+  struct Slot {
+    std::atomic<size_t> sequence;
+    uint32_t length;
+    uint32_t span;
+    char text[kSlotTextSize];
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+
+  /// Consumer-side scratch space that records spanning several slots are
+  /// reassembled into. Only touched by the consumer.
+  std::unique_ptr<char[]> scratch_;
+
+  /// The position the next producer will claim.
+  std::atomic<size_t> enqueuePosition_;
+
+  /// The position the consumer will read next. Only touched by the consumer.
+  size_t dequeuePosition_;
+
+  /// The number of records dropped because the queue was full.
+  std::atomic<size_t> dropped_;
+};
+
+template <typename Consumer>
+size_t FirebaseLogQueue::drain(Consumer consume) {
+  size_t count = 0;
+  for (;;) {
+    Slot& first = slots_[dequeuePosition_ & mask_];
+    if (first.sequence.load(std::memory_order_acquire) !=
+        dequeuePosition_ + 1) {
+      // Either the queue is empty or the next record is still being written.
+      break;
+    }
+    const size_t span = first.span;
+    if (span == 1) {
+      consume(first.text, first.length);
+    } else {
+      size_t remaining = first.length;
+      char* out = scratch_.get();
+      for (size_t i = 0; i < span; ++i) {
+        const Slot& slot = slots_[(dequeuePosition_ + i) & mask_];
+        const size_t chunk =
+            remaining < kSlotTextSize ? remaining : kSlotTextSize;
+        memcpy(out, slot.text, chunk);
+        out += chunk;
+        remaining -= chunk;
+      }
+      consume(scratch_.get(), static_cast<size_t>(first.length));
+    }
+    // Hand the slots back to producers for the next lap around the ring.
+    for (size_t i = 0; i < span; ++i) {
+      slots_[(dequeuePosition_ + i) & mask_].sequence.store(
+          dequeuePosition_ + i + mask_ + 1, std::memory_order_release);
+    }
+    dequeuePosition_ += span;
+    ++count;
+  }
+  return count;
+}
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_LOG_QUEUE_H_
@@ -0,0 +1,90 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseMemoryTracker.h"
+
+#include <string.h>
+
+#include <mutex>
+
+/// The registered types, newest last. Types are never unregistered.
+static FirebaseMemoryTracker::TypeCount* firstType = nullptr;
+static FirebaseMemoryTracker::TypeCount* lastType = nullptr;
+
+/// Guards the list of types. The counts themselves are atomic.
+static std::mutex typesMutex;
+
+FirebaseMemoryTracker::TypeCount* FirebaseMemoryTracker::registerType(
+    const char* name, bool releaseBeforeClose) {
+  std::lock_guard<std::mutex> lock(typesMutex);
+  for (TypeCount* type = firstType; type; type = type->next) {
+    if (strcmp(type->name, name) == 0) return type;
+  }
+  TypeCount* type = new TypeCount;
+  type->name = name;
+  type->releaseBeforeClose = releaseBeforeClose;
+  type->live.store(0, std::memory_order_relaxed);
+  type->highWater.store(0, std::memory_order_relaxed);
+  type->next = nullptr;
+  if (lastType) {
+    lastType->next = type;
+  } else {
+    firstType = type;
+  }
+  lastType = type;
+  return type;
+}
+
+void FirebaseMemoryTracker::added(TypeCount* type) {
+  const int live = type->live.fetch_add(1, std::memory_order_relaxed) + 1;
+  int highWater = type->highWater.load(std::memory_order_relaxed);
+  while (live > highWater &&
+         !type->highWater.compare_exchange_weak(highWater, live,
+                                                std::memory_order_relaxed)) {
+  }
+}
+
+void FirebaseMemoryTracker::removed(TypeCount* type) {
+  type->live.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FirebaseMemoryTracker::resetHighWaterMarks() {
+  std::lock_guard<std::mutex> lock(typesMutex);
+  for (TypeCount* type = firstType; type; type = type->next) {
+    type->highWater.store(type->live.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+  }
+}
+
+void FirebaseMemoryTracker::forEachType(
+    const std::function<void(const TypeCount&)>& visit) {
+  std::lock_guard<std::mutex> lock(typesMutex);
+  for (TypeCount* type = firstType; type; type = type->next) visit(*type);
+}
+
+int FirebaseMemoryTracker::getLiveCount(const char* name) {
+  std::lock_guard<std::mutex> lock(typesMutex);
+  for (TypeCount* type = firstType; type; type = type->next) {
+    if (strcmp(type->name, name) == 0) {
+      return type->live.load(std::memory_order_relaxed);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_MEMORY_TRACKER_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_MEMORY_TRACKER_H_
+
+#include <atomic>
+#include <functional>
+
+/// Counts the live objects of each tracked type, so memory growth over a long
+/// session can be measured and objects left behind by a scene caught.
+///
+/// A type is tracked by deriving it from FirebaseTracked. Each tracked type
+/// has a live count and a high-water mark; the marks are reset when a scene is
+/// created, so they give the peak count during that scene. When a sample's
+/// close button is tapped FirebaseScene::closeSample() logs the counts, and
+/// flags any type that must be released by then but still has live objects.
+///
+/// All methods are safe to call from any thread.
+class FirebaseMemoryTracker {
+ public:
+  /// The counts for one tracked type.
+  struct TypeCount {
+    /// The type's name, a string literal.
+    const char* name;
+    /// Whether objects still alive when the scene closes are reported as
+    /// leaks, for objects such as listeners that must not outlive the scene.
+    bool releaseBeforeClose;
+    /// The number of live objects.
+    std::atomic<int> live;
+    /// The most live objects at once since the last resetHighWaterMarks().
+    std::atomic<int> highWater;
+    /// The next registered type.
+    TypeCount* next;
+  };
+
+  /// Returns the counts for the type called `name`, registering it the first
+  /// time. Called once per type by FirebaseTracked.
+  static TypeCount* registerType(const char* name, bool releaseBeforeClose);
+
+  /// Counts an object of `type` being created.
+  static void added(TypeCount* type);
+
+  /// Counts an object of `type` being destroyed.
+  static void removed(TypeCount* type);
+
+  /// Sets every type's high-water mark to its live count.
+  static void resetHighWaterMarks();
+
+  /// Calls `visit` with each registered type, in registration order. `visit`
+  /// must not create the first object of a new tracked type.
+  static void forEachType(const std::function<void(const TypeCount&)>& visit);
+
+  /// Returns the number of live objects of the type called `name`, or 0 if
+  /// no such type has been registered.
+  static int getLiveCount(const char* name);
+};
+
+/// Derive a class from FirebaseTracked<Class> to count its live objects.
+/// `Class` must have a static trackedName() that returns a string literal.
+/// Set `releaseBeforeClose` for objects, such as listeners, that the scene
+/// must have destroyed by the time its close button has been handled.
+template <typename T, bool releaseBeforeClose = false>
+class FirebaseTracked {
+ protected:
+  FirebaseTracked() { FirebaseMemoryTracker::added(typeCount()); }
+  FirebaseTracked(const FirebaseTracked&) {
+    FirebaseMemoryTracker::added(typeCount());
+  }
+  ~FirebaseTracked() { FirebaseMemoryTracker::removed(typeCount()); }
+
+ private:
+  static FirebaseMemoryTracker::TypeCount* typeCount() {
+    static FirebaseMemoryTracker::TypeCount* count =
+        FirebaseMemoryTracker::registerType(T::trackedName(),
+                                            releaseBeforeClose);
+    return count;
+  }
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_MEMORY_TRACKER_H_
@@ -0,0 +1,177 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseProfiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "cocos2d.h"
+
+FirebaseProfiler::Section FirebaseProfiler::sections[kMaxSections];
+std::atomic<int> FirebaseProfiler::sectionCount(0);
+bool FirebaseProfiler::overlayEnabled = false;
+
+/// The font and size of the overlay text.
+static const char kOverlayFontFile[] = "fonts/arial.ttf";
+static const float kOverlayFontSize = 10.0;
+
+/// The number of seconds between overlay refreshes.
+static const float kOverlayRefreshInterval = 1.0f;
+
+uint64_t FirebaseProfiler::now() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+int FirebaseProfiler::section(const char* name) {
+  // Sections are registered once per call site, so a linear search is fine.
+  // Two threads registering the same name at once may create two sections.
+  const int count = sectionCount.load(std::memory_order_acquire);
+  for (int i = 0; i < count && i < kMaxSections; ++i) {
+    const char* existing = sections[i].name.load(std::memory_order_acquire);
+    if (existing && strcmp(existing, name) == 0) return i;
+  }
+  const int index = sectionCount.fetch_add(1, std::memory_order_acq_rel);
+  if (index >= kMaxSections) return -1;
+  sections[index].name.store(name, std::memory_order_release);
+  return index;
+}
+
+int FirebaseProfiler::bucketIndex(uint64_t nanoseconds) {
+  if (nanoseconds < 4) return static_cast<int>(nanoseconds);
+  // Four buckets per power of two, chosen by the two bits after the leading
+  // one.
+  int exponent = 63;
+  while (!(nanoseconds >> exponent)) --exponent;
+  const int mantissa = static_cast<int>((nanoseconds >> (exponent - 2)) & 3);
+  const int index = 4 * (exponent - 1) + mantissa;
+  return index < kBucketCount ? index : kBucketCount - 1;
+}
+
+uint64_t FirebaseProfiler::bucketLowerBound(int bucket) {
+  if (bucket < 4) return static_cast<uint64_t>(bucket);
+  const int exponent = bucket / 4 + 1;
+  const uint64_t mantissa = static_cast<uint64_t>(bucket % 4);
+  return (static_cast<uint64_t>(4) + mantissa) << (exponent - 2);
+}
+
+void FirebaseProfiler::record(int section, uint64_t nanoseconds) {
+  if (section < 0) return;
+  Section& entry = sections[section];
+  entry.buckets[bucketIndex(nanoseconds)].fetch_add(
+      1, std::memory_order_relaxed);
+  uint64_t max = entry.maxNanoseconds.load(std::memory_order_relaxed);
+  while (nanoseconds > max &&
+         !entry.maxNanoseconds.compare_exchange_weak(
+             max, nanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+size_t FirebaseProfiler::takeSummaries(Summary* summaries, size_t maxCount) {
+  size_t written = 0;
+  int count = sectionCount.load(std::memory_order_acquire);
+  if (count > kMaxSections) count = kMaxSections;
+  for (int i = 0; i < count && written < maxCount; ++i) {
+    Section& entry = sections[i];
+    const char* name = entry.name.load(std::memory_order_acquire);
+    if (!name) continue;
+
+    // Take the counts, resetting them for the next period. Durations recorded
+    // while this runs land in either this period or the next.
+    uint32_t buckets[kBucketCount];
+    uint64_t total = 0;
+    for (int b = 0; b < kBucketCount; ++b) {
+      buckets[b] = entry.buckets[b].exchange(0, std::memory_order_relaxed);
+      total += buckets[b];
+    }
+    const uint64_t max =
+        entry.maxNanoseconds.exchange(0, std::memory_order_relaxed);
+    if (total == 0) continue;
+
+    // Report the middle of the bucket each percentile falls in.
+    const uint64_t p50Rank = (total + 1) / 2;
+    const uint64_t p99Rank = total - total / 100;
+    double p50 = 0, p99 = 0;
+    uint64_t seen = 0;
+    for (int b = 0; b < kBucketCount; ++b) {
+      if (!buckets[b]) continue;
+      const uint64_t before = seen;
+      seen += buckets[b];
+      const double middle =
+          (bucketLowerBound(b) + (b + 1 < kBucketCount
+                                      ? bucketLowerBound(b + 1)
+                                      : bucketLowerBound(b))) /
+          2.0;
+      if (before < p50Rank && seen >= p50Rank) p50 = middle;
+      if (before < p99Rank && seen >= p99Rank) {
+        p99 = middle;
+        break;
+      }
+    }
+    Summary& summary = summaries[written++];
+    summary.name = name;
+    summary.count = total;
+    summary.p50Milliseconds = p50 / 1e6;
+    summary.p99Milliseconds = p99 / 1e6;
+    summary.maxMilliseconds = max / 1e6;
+  }
+  return written;
+}
+
+void FirebaseProfiler::attachOverlay(cocos2d::Node* parent) {
+#if FIREBASE_COCOS_PROFILER_ENABLED
+  cocos2d::Size visibleSize =
+      cocos2d::Director::getInstance()->getVisibleSize();
+  cocos2d::Vec2 origin = cocos2d::Director::getInstance()->getVisibleOrigin();
+  cocos2d::Label* label = cocos2d::Label::createWithTTF(
+      "", kOverlayFontFile, kOverlayFontSize);
+  label->setAnchorPoint(cocos2d::Vec2(1, 1));
+  label->setAlignment(cocos2d::TextHAlignment::RIGHT);
+  label->setPosition(cocos2d::Vec2(origin.x + visibleSize.width,
+                                   origin.y + visibleSize.height));
+  label->setTextColor(cocos2d::Color4B(255, 255, 0, 255));
+  parent->addChild(label, 1000);
+
+  label->schedule(
+      [label](float /*delta*/) {
+        Summary summaries[kMaxSections];
+        const size_t count = takeSummaries(summaries, kMaxSections);
+        std::string text = "section: p50 / p99 / max ms (calls/s)";
+        for (size_t i = 0; i < count; ++i) {
+          char line[128];
+          snprintf(line, sizeof(line), "\n%s: %.2f / %.2f / %.2f (%.0f)",
+                   summaries[i].name, summaries[i].p50Milliseconds,
+                   summaries[i].p99Milliseconds, summaries[i].maxMilliseconds,
+                   summaries[i].count / kOverlayRefreshInterval);
+          text += line;
+        }
+        label->setString(text);
+      },
+      kOverlayRefreshInterval, "FirebaseProfilerOverlay");
+#else
+  (void)parent;
+#endif
+}
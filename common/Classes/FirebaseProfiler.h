@@ -0,0 +1,145 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_PROFILER_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace cocos2d {
+class Node;
+}  // namespace cocos2d
+
+/// Whether FIREBASE_COCOS_PROFILE_SCOPE records anything. Defaults to on in
+/// debug builds; define it to 0 or 1 in the build to override.
+#if !defined(FIREBASE_COCOS_PROFILER_ENABLED)
+#if defined(COCOS2D_DEBUG) && COCOS2D_DEBUG > 0
+#define FIREBASE_COCOS_PROFILER_ENABLED 1
+#else
+#define FIREBASE_COCOS_PROFILER_ENABLED 0
+#endif
+#endif
+
+#define FIREBASE_COCOS_PROFILER_CONCAT_(a, b) a##b
+#define FIREBASE_COCOS_PROFILER_CONCAT(a, b) \
+  FIREBASE_COCOS_PROFILER_CONCAT_(a, b)
+
+/// Times the rest of the enclosing block and records it under `name`, which
+/// must be a string literal.
+#if FIREBASE_COCOS_PROFILER_ENABLED
+#define FIREBASE_COCOS_PROFILE_SCOPE(name)                                    \
+  static const int FIREBASE_COCOS_PROFILER_CONCAT(firebaseProfileSection,    \
+                                                  __LINE__) =                \
+      FirebaseProfiler::section(name);                                       \
+  FirebaseProfiler::Scope FIREBASE_COCOS_PROFILER_CONCAT(firebaseProfileScope, \
+                                                         __LINE__)(          \
+      FIREBASE_COCOS_PROFILER_CONCAT(firebaseProfileSection, __LINE__))
+#else
+#define FIREBASE_COCOS_PROFILE_SCOPE(name) \
+  do {                                     \
+  } while (0)
+#endif
+
+/// Collects timing histograms for named sections of code.
+///
+/// Each section has a histogram of durations with logarithmic buckets (four
+/// per power of two, so percentiles are accurate to within about 20%).
+/// Recording a duration is a single relaxed atomic increment, so sections may
+/// be timed on any thread. The histograms are reset each time a summary is
+/// taken, so a summary covers the time since the previous one.
+class FirebaseProfiler {
+ public:
+  /// The maximum number of sections. Sections past that are not recorded.
+  static const int kMaxSections = 64;
+
+  /// Per-section statistics for the period covered by a summary.
+  struct Summary {
+    const char* name;
+    uint64_t count;
+    double p50Milliseconds;
+    double p99Milliseconds;
+    double maxMilliseconds;
+  };
+
+  /// Times a scope. Use FIREBASE_COCOS_PROFILE_SCOPE rather than creating
+  /// these directly.
+  class Scope {
+   public:
+    explicit Scope(int section) : section_(section), start_(now()) {}
+    ~Scope() { record(section_, now() - start_); }
+
+   private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+
+    int section_;
+    uint64_t start_;
+  };
+
+  /// Returns the id of the section called `name`, registering it if needed.
+  /// `name` must outlive the profiler. Returns -1 if there are already
+  /// kMaxSections sections.
+  static int section(const char* name);
+
+  /// Records a duration for a section. Safe to call from any thread.
+  static void record(int section, uint64_t nanoseconds);
+
+  /// Fills `summaries` with up to `maxCount` summaries of the sections that
+  /// recorded anything since the last call, resets their histograms, and
+  /// returns the number written.
+  static size_t takeSummaries(Summary* summaries, size_t maxCount);
+
+  /// Adds a label to `parent` that shows each section's p50 and p99 times,
+  /// refreshed once per second. Does nothing if the profiler is compiled out.
+  static void attachOverlay(cocos2d::Node* parent);
+
+  /// Whether FirebaseScene attaches the overlay to each scene. Off by default.
+  static void setOverlayEnabled(bool enabled) { overlayEnabled = enabled; }
+  static bool isOverlayEnabled() { return overlayEnabled; }
+
+  /// The current time in nanoseconds, from a monotonic clock.
+  static uint64_t now();
+
+ private:
+  /// The number of histogram buckets. Durations past the last bucket (about
+  /// 17 seconds) are counted in it.
+  static const int kBucketCount = 132;
+
+  /// Returns the bucket a duration falls into.
+  static int bucketIndex(uint64_t nanoseconds);
+
+  /// Returns the smallest duration that falls into a bucket.
+  static uint64_t bucketLowerBound(int bucket);
+
+  struct Section {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> maxNanoseconds;
+    std::atomic<uint32_t> buckets[kBucketCount];
+  };
+
+  static Section sections[kMaxSections];
+  static std::atomic<int> sectionCount;
+  static bool overlayEnabled;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_PROFILER_H_
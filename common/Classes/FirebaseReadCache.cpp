@@ -0,0 +1,118 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseReadCache.h"
+
+#include <chrono>
+
+/// Returns the steady clock time in nanoseconds.
+static uint64_t cacheNow() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+FirebaseReadCache::FirebaseReadCache(double maxAgeSeconds)
+    : maxAge_(static_cast<uint64_t>(maxAgeSeconds * 1e9)),
+      generation_(0),
+      stats_() {}
+
+bool FirebaseReadCache::lookup(const std::string& path,
+                               firebase::Variant* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, Entry>::iterator it = entries_.find(path);
+  if (it != entries_.end() && it->second.expiry != 0 &&
+      it->second.expiry <= cacheNow()) {
+    entries_.erase(it);
+    it = entries_.end();
+  }
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return false;
+  }
+  ++stats_.hits;
+  *value = it->second.value;
+  return true;
+}
+
+uint64_t FirebaseReadCache::generation() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return generation_;
+}
+
+void FirebaseReadCache::fill(const std::string& path,
+                             const firebase::Variant& value,
+                             uint64_t generation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generation != generation_) return;
+  Entry entry;
+  entry.value = value;
+  entry.expiry = cacheNow() + maxAge_;
+  store(path, entry);
+}
+
+void FirebaseReadCache::mirror(const std::string& path,
+                               const firebase::Variant& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // A read started before this value arrived must not overwrite it.
+  ++generation_;
+  Entry entry;
+  entry.value = value;
+  entry.expiry = 0;
+  store(path, entry);
+}
+
+void FirebaseReadCache::invalidate(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  ++stats_.invalidations;
+  erase(path);
+}
+
+void FirebaseReadCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  entries_.clear();
+}
+
+FirebaseReadCache::Stats FirebaseReadCache::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.entries = entries_.size();
+  return stats;
+}
+
+void FirebaseReadCache::store(const std::string& path, const Entry& entry) {
+  erase(path);
+  entries_[path] = entry;
+  ++stats_.fills;
+}
+
+void FirebaseReadCache::erase(const std::string& path) {
+  entries_.erase(path);
+  // Descendants sort between "path/" and "path0", as '0' follows '/'.
+  entries_.erase(entries_.lower_bound(path + '/'),
+                 entries_.lower_bound(path + '0'));
+  for (size_t slash = path.find('/'); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    entries_.erase(path.substr(0, slash));
+  }
+}
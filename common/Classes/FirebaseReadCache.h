@@ -0,0 +1,109 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_READ_CACHE_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_READ_CACHE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "firebase/variant.h"
+
+/// A client-side cache of database values keyed by path, so that reading a
+/// value the app has just read, or is already listening to, finishes without
+/// a round trip.
+///
+/// Query results are cached with fill() and expire after a maximum age.
+/// Listener snapshots are cached with mirror() and stay valid until the path
+/// is invalidated, since the listener delivers every change. Writing a path,
+/// or a listener being cancelled, should invalidate() it. Caching or
+/// invalidating a path also drops its cached ancestors and descendants, whose
+/// values include it.
+///
+/// A read that was in flight while the path was written, or while a listener
+/// delivered a newer value, may return the old value. So reads pass the
+/// generation() from when they started to fill(), which ignores the value if
+/// anything has been invalidated or mirrored since.
+///
+/// Safe to call from any thread, so listeners may update it directly.
+class FirebaseReadCache {
+ public:
+  /// The cache's counters.
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t fills;
+    uint64_t invalidations;
+    size_t entries;
+  };
+
+  /// Creates a cache whose filled values expire after `maxAgeSeconds`.
+  explicit FirebaseReadCache(double maxAgeSeconds);
+
+  /// Returns true and sets `value` if `path` has a cached value that hasn't
+  /// expired. Counts a hit or a miss.
+  bool lookup(const std::string& path, firebase::Variant* value);
+
+  /// Returns the current generation, which changes on every invalidation and
+  /// every mirrored value.
+  uint64_t generation() const;
+
+  /// Caches `value`, the result of a read of `path` started at `generation`.
+  void fill(const std::string& path, const firebase::Variant& value,
+            uint64_t generation);
+
+  /// Caches `value`, delivered by a listener on `path`, until invalidated.
+  void mirror(const std::string& path, const firebase::Variant& value);
+
+  /// Drops `path`, its ancestors and its descendants.
+  void invalidate(const std::string& path);
+
+  /// Drops every entry. The counters are kept.
+  void clear();
+
+  /// Returns the current counters.
+  Stats getStats() const;
+
+ private:
+  struct Entry {
+    firebase::Variant value;
+    /// When the entry expires in steady clock nanoseconds, or 0 if never.
+    uint64_t expiry;
+  };
+
+  /// Stores `entry` at `path` after dropping the entries it replaces.
+  /// mutex_ must be held.
+  void store(const std::string& path, const Entry& entry);
+
+  /// Drops `path`, its ancestors and its descendants. mutex_ must be held.
+  void erase(const std::string& path);
+
+  const uint64_t maxAge_;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> entries_;
+  uint64_t generation_;
+  Stats stats_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_READ_CACHE_H_
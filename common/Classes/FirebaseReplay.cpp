@@ -0,0 +1,314 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FirebaseReplay.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "cocos2d.h"
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#define FIREBASE_COCOS_REPLAY_SUPPORTED 1
+#endif
+
+const char FirebaseReplay::kFutureChannel[] = "future";
+
+/// A recorded callback. `time` is in microseconds since recording started.
+struct ReplayEvent {
+  uint64_t time;
+  std::string channel;
+  FirebaseReplay::Fields fields;
+};
+
+/// A handler registered with setHandler().
+struct ReplayHandler {
+  std::string channel;
+  cocos2d::Ref* owner;
+  FirebaseReplay::Handler handler;
+};
+
+/// The recording state. recordMutex orders the lines written by different
+/// threads.
+static std::atomic<bool> recording(false);
+static std::mutex recordMutex;
+static FILE* recordFile = nullptr;
+static std::chrono::steady_clock::time_point recordStart;
+
+/// The replay state. Set up by startFromEnvironment() before any handler is
+/// registered, then only read.
+static bool replaying = false;
+static std::vector<ReplayEvent> replayEvents;
+static double replaySpeed = 1.0;
+static std::string replayReportPath;
+
+/// The registered handlers. handlerMutex is held while a handler runs, so
+/// removeHandlers() waits for it to return.
+static std::mutex handlerMutex;
+static std::vector<ReplayHandler> replayHandlers;
+static bool replayStarted = false;
+
+/// The replay results. Written by the replay thread, then read by finish().
+static std::vector<uint64_t> handlerTimes;
+static size_t unhandledCount = 0;
+static size_t futureCount = 0;
+static uint64_t replayTime = 0;
+
+/// Returns `field` with backslashes, tabs and newlines escaped.
+static std::string escapeField(const std::string& field) {
+  std::string escaped;
+  escaped.reserve(field.size());
+  for (char c : field) {
+    switch (c) {
+      case '\\': escaped += "\\\\"; break;
+      case '\t': escaped += "\\t"; break;
+      case '\n': escaped += "\\n"; break;
+      default: escaped += c;
+    }
+  }
+  return escaped;
+}
+
+#if FIREBASE_COCOS_REPLAY_SUPPORTED
+/// Reverses escapeField().
+static std::string unescapeField(const std::string& field) {
+  std::string unescaped;
+  unescaped.reserve(field.size());
+  for (size_t i = 0; i < field.size(); ++i) {
+    char c = field[i];
+    if (c == '\\' && i + 1 < field.size()) {
+      c = field[++i];
+      if (c == 't') c = '\t';
+      if (c == 'n') c = '\n';
+    }
+    unescaped += c;
+  }
+  return unescaped;
+}
+
+/// Reads the events recorded in `path` into replayEvents. Returns false if
+/// the file couldn't be read.
+static bool loadEvents(const std::string& path) {
+  std::ifstream file(path.c_str());
+  if (!file) return false;
+  std::string line;
+  while (std::getline(file, line)) {
+    // Split "time\tchannel\tfield...".
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (true) {
+      const size_t end = line.find('\t', begin);
+      parts.push_back(unescapeField(line.substr(begin, end - begin)));
+      if (end == std::string::npos) break;
+      begin = end + 1;
+    }
+    if (parts.size() < 2) {
+      fprintf(stderr, "FirebaseReplay: ignoring line `%s`\n", line.c_str());
+      continue;
+    }
+    ReplayEvent event;
+    event.time = strtoull(parts[0].c_str(), nullptr, 10);
+    event.channel = parts[1];
+    event.fields.assign(parts.begin() + 2, parts.end());
+    replayEvents.push_back(event);
+  }
+  return true;
+}
+#endif  // FIREBASE_COCOS_REPLAY_SUPPORTED
+
+bool FirebaseReplay::startRecording(const std::string& path) {
+  std::lock_guard<std::mutex> lock(recordMutex);
+  if (recordFile || replaying) return false;
+  recordFile = fopen(path.c_str(), "w");
+  if (!recordFile) return false;
+  recordStart = std::chrono::steady_clock::now();
+  recording.store(true, std::memory_order_release);
+  return true;
+}
+
+void FirebaseReplay::startFromEnvironment() {
+#if FIREBASE_COCOS_REPLAY_SUPPORTED
+  const char* path = getenv("FIREBASE_COCOS_REPLAY");
+  if (!path || !*path || isRecording()) return;
+  if (!loadEvents(path)) {
+    fprintf(stderr, "FirebaseReplay: could not read `%s`\n", path);
+    return;
+  }
+  const char* speed = getenv("FIREBASE_COCOS_REPLAY_SPEED");
+  if (speed) replaySpeed = std::max(0.0, atof(speed));
+  const char* report = getenv("FIREBASE_COCOS_REPLAY_REPORT");
+  replayReportPath = report ? report : "";
+  handlerTimes.reserve(replayEvents.size());
+  replaying = true;
+#endif
+}
+
+bool FirebaseReplay::isRecording() {
+  return recording.load(std::memory_order_acquire);
+}
+
+bool FirebaseReplay::isReplaying() { return replaying; }
+
+void FirebaseReplay::record(const char* channel, const Fields& fields) {
+  if (!isRecording()) return;
+  std::string line(channel);
+  for (const std::string& field : fields) {
+    line += '\t';
+    line += escapeField(field);
+  }
+
+  std::lock_guard<std::mutex> lock(recordMutex);
+  const uint64_t time = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - recordStart)
+          .count());
+  fprintf(recordFile, "%" PRIu64 "\t%s\n", time, line.c_str());
+  // Mobile apps are usually killed rather than exiting, so don't leave lines
+  // in the stdio buffer.
+  fflush(recordFile);
+}
+
+std::string FirebaseReplay::formatInt(int64_t value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+  return buffer;
+}
+
+std::string FirebaseReplay::formatDouble(double value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.17g", value);
+  return buffer;
+}
+
+void FirebaseReplay::setHandler(const char* channel, cocos2d::Ref* owner,
+                                const Handler& handler) {
+  if (!replaying) return;
+  std::lock_guard<std::mutex> lock(handlerMutex);
+  ReplayHandler entry;
+  entry.channel = channel;
+  entry.owner = owner;
+  entry.handler = handler;
+  replayHandlers.push_back(entry);
+  if (replayStarted) return;
+  replayStarted = true;
+  // Start on the next frame, so the scene registering this handler has
+  // finished registering the rest.
+  cocos2d::Director::getInstance()
+      ->getScheduler()
+      ->performFunctionInCocosThread([]() { std::thread(replay).detach(); });
+}
+
+void FirebaseReplay::removeHandlers(cocos2d::Ref* owner) {
+  std::lock_guard<std::mutex> lock(handlerMutex);
+  replayHandlers.erase(
+      std::remove_if(replayHandlers.begin(), replayHandlers.end(),
+                     [owner](const ReplayHandler& entry) {
+                       return entry.owner == owner;
+                     }),
+      replayHandlers.end());
+}
+
+void FirebaseReplay::replay() {
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  for (const ReplayEvent& event : replayEvents) {
+    if (replaySpeed > 0) {
+      std::this_thread::sleep_until(
+          start + std::chrono::microseconds(
+                      static_cast<uint64_t>(event.time / replaySpeed)));
+    }
+    if (event.channel == kFutureChannel) {
+      ++futureCount;
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(handlerMutex);
+    // The newest handler wins, which is the scene on top in the host app.
+    auto entry = std::find_if(replayHandlers.rbegin(), replayHandlers.rend(),
+                              [&event](const ReplayHandler& handler) {
+                                return handler.channel == event.channel;
+                              });
+    if (entry == replayHandlers.rend()) {
+      ++unhandledCount;
+      continue;
+    }
+    const Clock::time_point handlerStart = Clock::now();
+    entry->handler(event.fields);
+    handlerTimes.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                             handlerStart)
+            .count()));
+  }
+  replayTime = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           start)
+          .count());
+  cocos2d::Director::getInstance()
+      ->getScheduler()
+      ->performFunctionInCocosThread(finish);
+}
+
+void FirebaseReplay::finish() {
+  const double seconds = replayTime / 1e9;
+  std::vector<uint64_t> sorted(handlerTimes);
+  std::sort(sorted.begin(), sorted.end());
+  uint64_t total = 0;
+  for (size_t i = 0; i < sorted.size(); ++i) total += sorted[i];
+  const size_t count = sorted.size();
+
+  FILE* file =
+      replayReportPath.empty() ? stdout : fopen(replayReportPath.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "FirebaseReplay: could not open `%s`\n",
+            replayReportPath.c_str());
+    file = stdout;
+  }
+  fprintf(file, "events: %zu\n", replayEvents.size());
+  fprintf(file, "delivered: %zu\n", count);
+  fprintf(file, "unhandled: %zu\n", unhandledCount);
+  fprintf(file, "futures: %zu\n", futureCount);
+  fprintf(file, "speed: %.2f\n", replaySpeed);
+  fprintf(file, "seconds: %.3f\n", seconds);
+  fprintf(file, "events_per_second: %.1f\n",
+          seconds > 0 ? count / seconds : 0.0);
+  if (count > 0) {
+    const size_t p99Index = count - 1 - count / 100;
+    fprintf(file, "handler_us_mean: %.3f\n", total / 1e3 / count);
+    fprintf(file, "handler_us_p50: %.3f\n", sorted[count / 2] / 1e3);
+    fprintf(file, "handler_us_p99: %.3f\n", sorted[p99Index] / 1e3);
+    fprintf(file, "handler_us_max: %.3f\n", sorted[count - 1] / 1e3);
+  }
+  if (file == stdout) {
+    fflush(file);
+  } else {
+    fclose(file);
+  }
+
+  cocos2d::Director::getInstance()->end();
+}
@@ -0,0 +1,110 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_REPLAY_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_REPLAY_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cocos2d {
+class Ref;
+}  // namespace cocos2d
+
+/// Records the Firebase callbacks a session receives, and replays them later
+/// so the scenes' handling code can be benchmarked offline.
+///
+/// While recording, each listener callback and Future completion is written
+/// as one line of a text stream: the microseconds since recording started, a
+/// channel name such as "database.value", and the callback's arguments as
+/// strings. Lines are written in the order the callbacks ran, from whichever
+/// thread they ran on.
+///
+/// Replay reads a recorded stream and hands each event to the handler a scene
+/// registered for its channel. Handlers rebuild the callback's arguments and
+/// run the same listener code a live callback would. Events are delivered in
+/// order from a replay thread, as the SDK calls listeners from its own
+/// threads, either at their recorded times or back to back. When the stream
+/// ends the event count and handler latencies are reported and the app quits.
+///
+/// Future completions are recorded so the stream shows where they fell among
+/// the listener callbacks, but they are not delivered on replay: completed
+/// Futures can only be made by the SDK. They are counted in the report.
+class FirebaseReplay {
+ public:
+  /// The arguments of a recorded callback.
+  typedef std::vector<std::string> Fields;
+
+  /// Handles a replayed event. Called on the replay thread.
+  typedef std::function<void(const Fields& fields)> Handler;
+
+  /// The channel Future completions are recorded on. Its fields are the name
+  /// of the Future's trace span, the error code and the error message.
+  static const char kFutureChannel[];
+
+  /// Starts writing callbacks to `path`. Returns false if the file couldn't
+  /// be opened or recording or replay has already started.
+  static bool startRecording(const std::string& path);
+
+  /// Replays the stream named by FIREBASE_COCOS_REPLAY, if it is set. Only
+  /// supported on Linux, where it is meant to run. Replay begins when the
+  /// first handler is registered. FIREBASE_COCOS_REPLAY_SPEED scales the
+  /// recorded gaps between events; 0 delivers them back to back and the
+  /// default is 1. The report goes to FIREBASE_COCOS_REPLAY_REPORT, or
+  /// stdout.
+  static void startFromEnvironment();
+
+  /// Returns true while recording. Callers check this before building the
+  /// fields of an event.
+  static bool isRecording();
+
+  /// Returns true if a stream is being replayed.
+  static bool isReplaying();
+
+  /// Records an event on `channel`, which must be a string literal. Does
+  /// nothing unless recording. May be called from any thread.
+  static void record(const char* channel, const Fields& fields);
+
+  /// Format numbers as fields, so that they read back exactly.
+  static std::string formatInt(int64_t value);
+  static std::string formatDouble(double value);
+
+  /// Calls `handler` for each replayed event on `channel`, until
+  /// removeHandlers(owner) is called. Does nothing unless replaying.
+  static void setHandler(const char* channel, cocos2d::Ref* owner,
+                         const Handler& handler);
+
+  /// Removes the handlers registered by `owner`. Once this returns none of
+  /// them is running or will run again.
+  static void removeHandlers(cocos2d::Ref* owner);
+
+ private:
+  /// Delivers the events. Runs on the replay thread.
+  static void replay();
+
+  /// Writes the replay report and quits the app.
+  static void finish();
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_REPLAY_H_
@@ -0,0 +1,152 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseRequestPipeline.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+/// Returns the steady clock time in nanoseconds.
+static uint64_t pipelineNow() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+FirebaseRequestPipeline::FirebaseRequestPipeline()
+    : maxInFlight_(1),
+      burstSize_(1),
+      inFlight_(0),
+      starting_(false),
+      succeeded_(0),
+      failed_(0),
+      runStartTime_(0),
+      runFinished_(0),
+      lastFinishTime_(0),
+      nextLatency_(0) {
+  latencies_.reserve(kLatencySamples);
+}
+
+void FirebaseRequestPipeline::setMaxInFlight(int maxInFlight) {
+  maxInFlight_ = std::max(maxInFlight, 1);
+  startQueued();
+}
+
+void FirebaseRequestPipeline::setBurstSize(int burstSize) {
+  burstSize_ = std::max(burstSize, 1);
+}
+
+void FirebaseRequestPipeline::push(const Request& request) {
+  if (inFlight_ == 0 && queue_.empty()) {
+    runStartTime_ = pipelineNow();
+    runFinished_ = 0;
+  }
+  queue_.push_back(request);
+  startQueued();
+}
+
+void FirebaseRequestPipeline::pushBurst(const Request& request) {
+  for (int i = 0; i < burstSize_; ++i) push(request);
+}
+
+void FirebaseRequestPipeline::clear() { queue_.clear(); }
+
+void FirebaseRequestPipeline::startQueued() {
+  if (starting_) return;
+  starting_ = true;
+  while (inFlight_ < maxInFlight_ && !queue_.empty()) {
+    Request request = queue_.front();
+    queue_.pop_front();
+    ++inFlight_;
+    const uint64_t startTime = pipelineNow();
+    std::shared_ptr<bool> finished = std::make_shared<bool>(false);
+    request([this, startTime, finished](bool succeeded) {
+      if (*finished) return;
+      *finished = true;
+      finish(startTime, succeeded);
+    });
+  }
+  starting_ = false;
+}
+
+void FirebaseRequestPipeline::finish(uint64_t startTime, bool succeeded) {
+  const uint64_t now = pipelineNow();
+  if (latencies_.size() < kLatencySamples) {
+    latencies_.push_back(now - startTime);
+  } else {
+    latencies_[nextLatency_] = now - startTime;
+    nextLatency_ = (nextLatency_ + 1) % kLatencySamples;
+  }
+  if (succeeded) {
+    ++succeeded_;
+  } else {
+    ++failed_;
+  }
+  ++runFinished_;
+  lastFinishTime_ = now;
+  --inFlight_;
+  startQueued();
+}
+
+FirebaseRequestPipeline::Stats FirebaseRequestPipeline::getStats() const {
+  Stats stats = Stats();
+  stats.queued = static_cast<int>(queue_.size());
+  stats.inFlight = inFlight_;
+  stats.succeeded = succeeded_;
+  stats.failed = failed_;
+
+  // A run that is still going is timed up to now.
+  const bool running = inFlight_ > 0 || !queue_.empty();
+  const uint64_t runEnd = running ? pipelineNow() : lastFinishTime_;
+  if (runFinished_ > 0 && runEnd > runStartTime_) {
+    stats.requestsPerSecond = runFinished_ * 1e9 / (runEnd - runStartTime_);
+  }
+
+  if (!latencies_.empty()) {
+    std::vector<uint64_t> sorted(latencies_);
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t total = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) total += sorted[i];
+    const size_t count = sorted.size();
+    stats.latencyMsMean = total / 1e6 / count;
+    stats.latencyMsP50 = sorted[count / 2] / 1e6;
+    stats.latencyMsP99 = sorted[count - 1 - count / 100] / 1e6;
+    stats.latencyMsMax = sorted[count - 1] / 1e6;
+  }
+  return stats;
+}
+
+std::string FirebaseRequestPipeline::getStatsText() const {
+  const Stats stats = getStats();
+  char text[256];
+  snprintf(text, sizeof(text),
+           "%d queued, %d/%d in flight, %llu ok, %llu failed\n"
+           "%.1f req/s, latency ms p50 %.1f p99 %.1f max %.1f",
+           stats.queued, stats.inFlight, maxInFlight_,
+           static_cast<unsigned long long>(stats.succeeded),
+           static_cast<unsigned long long>(stats.failed),
+           stats.requestsPerSecond, stats.latencyMsP50, stats.latencyMsP99,
+           stats.latencyMsMax);
+  return text;
+}
@@ -0,0 +1,123 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_REQUEST_PIPELINE_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_REQUEST_PIPELINE_H_
+
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// Queues a scene's requests and keeps up to a set number of them in flight,
+/// so a button tap can start a burst of operations rather than one request
+/// that blocks the UI until it completes.
+///
+/// A request is a function that starts an operation and calls the Done
+/// function it is given once the operation's result has been handled. The
+/// pipeline starts queued requests in order whenever fewer than
+/// getMaxInFlight() are running, and times each one from start to done.
+///
+/// All methods, and the Done functions, must be called on the cocos thread.
+/// Done may be called from within the request itself, for example when a
+/// result is already cached.
+class FirebaseRequestPipeline {
+ public:
+  /// Reports that a request has finished. Only the first call counts.
+  typedef std::function<void(bool succeeded)> Done;
+
+  /// Starts an operation and calls `done` when it finishes.
+  typedef std::function<void(const Done& done)> Request;
+
+  /// The pipeline's counters. Throughput covers the current run, which starts
+  /// when a request is queued on an idle pipeline. Latencies cover the most
+  /// recent requests, up to kLatencySamples of them.
+  struct Stats {
+    int queued;
+    int inFlight;
+    uint64_t succeeded;
+    uint64_t failed;
+    double requestsPerSecond;
+    double latencyMsMean;
+    double latencyMsP50;
+    double latencyMsP99;
+    double latencyMsMax;
+  };
+
+  /// The number of latencies kept for the percentiles.
+  static const size_t kLatencySamples = 1024;
+
+  FirebaseRequestPipeline();
+
+  /// Sets the number of requests that may run at once. Lowering it lets the
+  /// running requests finish; raising it starts queued requests right away.
+  void setMaxInFlight(int maxInFlight);
+  int getMaxInFlight() const { return maxInFlight_; }
+
+  /// Sets the number of times pushBurst() queues its request.
+  void setBurstSize(int burstSize);
+  int getBurstSize() const { return burstSize_; }
+
+  /// Queues `request`, starting it right away if there is room.
+  void push(const Request& request);
+
+  /// Queues getBurstSize() copies of `request`.
+  void pushBurst(const Request& request);
+
+  /// Drops the requests that haven't started. Requests in flight still finish
+  /// and are counted.
+  void clear();
+
+  /// Returns the current counters.
+  Stats getStats() const;
+
+  /// Formats getStats() as a line of text for the screen.
+  std::string getStatsText() const;
+
+ private:
+  /// Starts queued requests until the in-flight limit is reached.
+  void startQueued();
+
+  /// Counts a request started at `startTime` as finished.
+  void finish(uint64_t startTime, bool succeeded);
+
+  std::deque<Request> queue_;
+  int maxInFlight_;
+  int burstSize_;
+  int inFlight_;
+  /// Set while startQueued() is running, so a request that finishes as it
+  /// starts doesn't start the next one recursively.
+  bool starting_;
+
+  uint64_t succeeded_;
+  uint64_t failed_;
+  /// The start of the current run, and the requests finished in it.
+  uint64_t runStartTime_;
+  uint64_t runFinished_;
+  uint64_t lastFinishTime_;
+
+  /// The latest latencies in nanoseconds, as a ring buffer.
+  std::vector<uint64_t> latencies_;
+  size_t nextLatency_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_REQUEST_PIPELINE_H_
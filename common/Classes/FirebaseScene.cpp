@@ -20,7 +20,14 @@
 
 #include "FirebaseScene.h"
 
+#include <math.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include <android/log.h>
@@ -29,6 +36,11 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseFramePacer.h"
+#include "FirebaseLogBuffer.h"
+#include "FirebaseLogQueue.h"
+#include "FirebaseReplay.h"
 
 USING_NS_CC;
 
@@ -46,18 +58,59 @@ static const float kButtonTitleFontSize = 12.0;
 /// The content size for the Firebase buttons.
 static const cocos2d::Size kButtonContentSize = cocos2d::Size(150, 20);
 
-/// The factor used to determine when to resize the ScrollView's inner container
-/// height.
-static const float kScrollViewContainerHeightFactor = 0.85;
+/// The font and font size of the log text.
+static const std::string kLogFontFile = "fonts/arial.ttf";
+static const float kLogFontSize = 12.0;
+
+/// The values the request pipeline buttons step through.
+static const int kMaxInFlightSteps[] = {1, 4, 16, 64};
+static const int kBurstSizeSteps[] = {1, 10, 100, 1000};
+
+/// The font size, height and refresh interval of the request pipeline stats.
+static const float kPipelineStatsFontSize = 10.0;
+static const float kPipelineStatsHeight = 28.0;
+static const float kPipelineStatsInterval = 0.25f;
+static const char kPipelineStatsScheduleKey[] = "FirebaseRequestPipeline";
+
+/// The line number of a log row that isn't showing a line.
+static const size_t kNoLogLine = static_cast<size_t>(-1);
+
+/// The default line and byte budgets for the log buffer.
+static const size_t kDefaultLogMaxLines = 512;
+static const size_t kDefaultLogMaxBytes = 64 * 1024;
+
+/// The number of log queue slots. Long lines take up several slots.
+static const size_t kLogQueueCapacity = 1024;
+
+/// The size of each thread's log formatting arena. Lines that don't fit are
+/// formatted into a temporary heap buffer instead.
+static const size_t kLogArenaSize = 1024;
+
+/// The storage each thread formats its log lines into.
+static thread_local char logArena[kLogArenaSize];
 
-/// The logging ScrollView.
-cocos2d::ui::ScrollView* scrollView;
+/// Log records pushed by logMessage from any thread, waiting to be moved into
+/// logBuffer on the Cocos2d thread.
+static FirebaseLogQueue logQueue(kLogQueueCapacity);
 
-/// The log text for the Text Widget.
-cocos2d::ui::Text* logTextWidget;
+/// The log lines. Old lines are evicted once the budgets are reached, so the
+/// cost of logging doesn't grow with the length of the session. Only accessed
+/// on the Cocos2d thread.
+static FirebaseLogBuffer* logBuffer =
+    new FirebaseLogBuffer(kDefaultLogMaxLines, kDefaultLogMaxBytes);
 
-/// The log text.
-std::string logTextString;
+/// Counts the buffers setLogCapacity() has replaced logBuffer with, so each
+/// scene's log view knows when its rows' line numbers have started over.
+static unsigned logBufferGeneration = 0;
+
+/// The name and size of the binary log file.
+static const char kBinaryLogFileName[] = "firebase_log.bin";
+static const size_t kBinaryLogCapacity = 16 * 1024 * 1024;
+
+std::atomic<unsigned> FirebaseScene::logSinks(FirebaseScene::kLogSinkText);
+FirebaseBinaryLog* FirebaseScene::binaryLog = nullptr;
+std::atomic<int> FirebaseScene::logLevelThreshold(
+    FIREBASE_COCOS_MIN_LOG_LEVEL);
 
 cocos2d::ui::Button* FirebaseScene::createButton(
     bool buttonEnabled, const std::string& buttonTitleText,
@@ -84,6 +137,55 @@ cocos2d::ui::Button* FirebaseScene::createButton(
   return createButton(buttonEnabled, buttonTitleText, cocos2d::Color3B::WHITE);
 }
 
+FirebaseScene::FirebaseScene()
+    : scrollView_(nullptr),
+      logRowHeight_(1.0f),
+      logRowsLayoutOffset_(0.0f),
+      logRowsBufferGeneration_(logBufferGeneration),
+      logViewStale_(false) {
+  // The high-water marks reported when the scene closes are for this scene.
+  FirebaseMemoryTracker::resetHighWaterMarks();
+}
+
+void FirebaseScene::logMemoryReport() {
+  FirebaseMemoryTracker::forEachType(
+      [this](const FirebaseMemoryTracker::TypeCount& type) {
+        const int live = type.live.load(std::memory_order_relaxed);
+        const int highWater = type.highWater.load(std::memory_order_relaxed);
+        if (type.releaseBeforeClose && live > 0) {
+          FIREBASE_COCOS_LOG_WARN(
+              this, "%d %s still alive at close (peak %d).", live, type.name,
+              highWater);
+        } else {
+          FIREBASE_COCOS_LOG_DEBUG(this, "%s: %d live, peak %d.", type.name,
+                                   live, highWater);
+        }
+      });
+}
+
+void FirebaseScene::closeSample() {
+  FirebaseReplay::removeHandlers(this);
+  const int dropped = FirebaseCompletionDispatcher::dropOwner(this);
+  if (dropped > 0) {
+    FIREBASE_COCOS_LOG_DEBUG(
+        this, "Dropped %d callbacks still pending at close.", dropped);
+  }
+  logMemoryReport();
+  flushLogSinks();
+
+#if defined(FIREBASE_COCOS_HOST_APP)
+  // The host app pushed this scene over its menu.
+  Director::getInstance()->popScene();
+#else
+  // Close the cocos2d-x game scene and quit the application.
+  Director::getInstance()->end();
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+  exit(0);
+#endif
+#endif
+}
+
 cocos2d::ui::TextField* FirebaseScene::createTextField(
     const char* placeholder) {
   auto visibleSize = Director::getInstance()->getVisibleSize();
@@ -97,76 +199,283 @@ cocos2d::ui::TextField* FirebaseScene::createTextField(
   return text_field;
 }
 
+/// Returns the value after `value` in `steps`, wrapping around to the first.
+template <size_t N>
+static int nextStep(const int (&steps)[N], int value) {
+  for (size_t i = 0; i + 1 < N; ++i) {
+    if (steps[i] == value) return steps[i + 1];
+  }
+  return steps[0];
+}
+
+void FirebaseScene::createRequestPipelineControls(
+    FirebaseRequestPipeline* pipeline) {
+  char title[64];
+  snprintf(title, sizeof(title), "In Flight: %d", pipeline->getMaxInFlight());
+  cocos2d::ui::Button* inFlightButton = createButton(true, title);
+  inFlightButton->addTouchEventListener(
+      [pipeline, inFlightButton](Ref* /*sender*/,
+                                 cocos2d::ui::Widget::TouchEventType type) {
+        if (type != cocos2d::ui::Widget::TouchEventType::ENDED) return;
+        pipeline->setMaxInFlight(
+            nextStep(kMaxInFlightSteps, pipeline->getMaxInFlight()));
+        char title[64];
+        snprintf(title, sizeof(title), "In Flight: %d",
+                 pipeline->getMaxInFlight());
+        inFlightButton->setTitleText(title);
+      });
+  this->addChild(inFlightButton);
+
+  snprintf(title, sizeof(title), "Burst: %d", pipeline->getBurstSize());
+  cocos2d::ui::Button* burstButton = createButton(true, title);
+  burstButton->addTouchEventListener(
+      [pipeline, burstButton](Ref* /*sender*/,
+                              cocos2d::ui::Widget::TouchEventType type) {
+        if (type != cocos2d::ui::Widget::TouchEventType::ENDED) return;
+        pipeline->setBurstSize(
+            nextStep(kBurstSizeSteps, pipeline->getBurstSize()));
+        char title[64];
+        snprintf(title, sizeof(title), "Burst: %d", pipeline->getBurstSize());
+        burstButton->setTitleText(title);
+      });
+  this->addChild(burstButton);
+
+  auto visibleSize = Director::getInstance()->getVisibleSize();
+  cocos2d::Vec2 origin = Director::getInstance()->getVisibleOrigin();
+  cocos2d::Label* stats = cocos2d::Label::createWithTTF(
+      pipeline->getStatsText(), kLogFontFile, kPipelineStatsFontSize);
+  stats->setDimensions(visibleSize.width / 2 - kUIElementPadding * 2,
+                       kPipelineStatsHeight);
+  stats->setAlignment(cocos2d::TextHAlignment::CENTER);
+  nextYPosition -= kPipelineStatsHeight / 2 + kUIElementPadding;
+  stats->setPosition(
+      cocos2d::Vec2(origin.x + visibleSize.width / 4, nextYPosition));
+  this->addChild(stats);
+
+  // Scheduled on the scene, so the refresh stops when the scene goes away.
+  this->schedule(
+      [pipeline, stats](float /*delta*/) {
+        const std::string text = pipeline->getStatsText();
+        if (text != stats->getString()) stats->setString(text);
+      },
+      kPipelineStatsInterval, kPipelineStatsScheduleKey);
+}
+
 void FirebaseScene::createScrollView(float yPosition, float widthFraction) {
   cocos2d::Size visibleSize = Director::getInstance()->getVisibleSize();
   cocos2d::Vec2 origin = Director::getInstance()->getVisibleOrigin();
 
-  scrollView = cocos2d::ui::ScrollView::create();
+  scrollView_ = cocos2d::ui::ScrollView::create();
   auto scrollViewFrameSize =
     Size(visibleSize.width * (1 - widthFraction), yPosition);
-  scrollView->setContentSize(scrollViewFrameSize);
-  scrollView->setPosition(
+  scrollView_->setContentSize(scrollViewFrameSize);
+  scrollView_->setPosition(
       cocos2d::Point(origin.x + visibleSize.width * widthFraction, origin.y));
   cocos2d::Size scrollViewContainerSize =
       cocos2d::Size(scrollViewFrameSize.width, scrollViewFrameSize.height);
-  scrollView->setInnerContainerSize(scrollViewContainerSize);
+  scrollView_->setInnerContainerSize(scrollViewContainerSize);
+
+  // Create just enough rows to cover the ScrollView, plus one for the row
+  // that is partly scrolled out of view. Lines too long for a row are clipped
+  // rather than wrapped, so every row has the same height.
+  logRows_.clear();
+  logRowsBufferGeneration_ = logBufferGeneration;
+  size_t rowCount = 1;
+  for (size_t i = 0; i < rowCount; ++i) {
+    cocos2d::Label* label =
+        cocos2d::Label::createWithTTF("", kLogFontFile, kLogFontSize);
+    if (i == 0) {
+      logRowHeight_ = std::max(label->getLineHeight(), 1.0f);
+      rowCount = static_cast<size_t>(
+                     ceilf(scrollViewFrameSize.height / logRowHeight_)) + 1;
+    }
+    label->setDimensions(scrollViewContainerSize.width, logRowHeight_);
+    label->setOverflow(cocos2d::Label::Overflow::CLAMP);
+    label->setAnchorPoint(cocos2d::Vec2(0, 1));
+    label->setVisible(false);
+    scrollView_->addChild(label);
+    LogRow row = {label, kNoLogLine};
+    logRows_.push_back(row);
+  }
+
+  this->addChild(scrollView_);
 
-  logTextWidget = cocos2d::ui::Text::create("", "fonts/arial.ttf", 12);
-  logTextWidget->setTextAreaSize(
-      cocos2d::Size(scrollViewContainerSize.width, 0));
-  scrollView->addChild(logTextWidget);
+  // Refresh the log once per frame, after the scene's own update, so a burst
+  // of log messages only lays out the rows once. Anything logged before the
+  // ScrollView existed is shown on the first flush.
+  logViewStale_ = true;
+  this->schedule(CC_SCHEDULE_SELECTOR(FirebaseScene::flushLog));
 
-  this->addChild(scrollView);
+  if (FirebaseProfiler::isOverlayEnabled()) {
+    FirebaseProfiler::attachOverlay(this);
+  }
 }
 
 void FirebaseScene::createScrollView(float yPosition) {
   createScrollView(yPosition, 0.5f);
 }
 
+void FirebaseScene::setLogCapacity(size_t maxLines, size_t maxBytes) {
+  delete logBuffer;
+  logBuffer = new FirebaseLogBuffer(maxLines, maxBytes);
+  // Line numbers start over in the new buffer, so every scene's rows are
+  // reset on its next flush.
+  ++logBufferGeneration;
+}
+
+void FirebaseScene::onEnter() {
+  cocos2d::Layer::onEnter();
+  logViewStale_ = true;
+}
+
+void FirebaseScene::setLogSinks(unsigned sinks) {
+  if ((sinks & kLogSinkBinary) && !binaryLog) {
+    const std::string path =
+        FileUtils::getInstance()->getWritablePath() + kBinaryLogFileName;
+    binaryLog = FirebaseBinaryLog::open(path, kBinaryLogCapacity);
+    if (!binaryLog) {
+      CCLOG("Unable to create the binary log %s", path.c_str());
+      sinks &= ~kLogSinkBinary;
+    }
+  }
+  // Publishes binaryLog to threads that see the binary sink enabled.
+  logSinks.store(sinks, std::memory_order_release);
+}
+
+void FirebaseScene::flushLogSinks() {
+  if (binaryLog) binaryLog->flush();
+}
+
 /// Adds text to the log TextWidget.
-void FirebaseScene::logMessage(std::string format, ...) {
-  static const int kLineBufferSize = 100;
-  char buffer[kLineBufferSize + 2];
+void FirebaseScene::logFormatted(LogLevel level, const char* format, ...) {
+  // Warnings and errors are called out in the on-screen log.
+  const char* prefix = "";
+  if (level == kLogLevelWarn) {
+    prefix = "WARNING: ";
+  } else if (level == kLogLevelError) {
+    prefix = "ERROR: ";
+  }
+  const size_t prefixLength = strlen(prefix);
+  memcpy(logArena, prefix, prefixLength);
 
   va_list list;
   va_start(list, format);
-  vsnprintf(buffer, kLineBufferSize, format.c_str(), list);
+  va_list retryList;
+  va_copy(retryList, list);
+  int length = vsnprintf(logArena + prefixLength,
+                         kLogArenaSize - prefixLength, format, list);
+  va_end(list);
+  if (length < 0) {
+    va_end(retryList);
+    return;
+  }
+  length += static_cast<int>(prefixLength);
+
+  const char* text = logArena;
+  std::unique_ptr<char[]> overflow;
+  if (static_cast<size_t>(length) >= kLogArenaSize) {
+    // The line doesn't fit in the arena, so format it again into a buffer
+    // that does.
+    overflow.reset(new char[length + 1]);
+    memcpy(overflow.get(), prefix, prefixLength);
+    vsnprintf(overflow.get() + prefixLength, length + 1 - prefixLength, format,
+              retryList);
+    text = overflow.get();
+  }
+  va_end(retryList);
+
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
-  __android_log_vprint(ANDROID_LOG_INFO, "FIREBASE-COCOS", format.c_str(),
-                       list);
+  static const int kAndroidPriorities[] = {
+      ANDROID_LOG_VERBOSE, ANDROID_LOG_DEBUG, ANDROID_LOG_INFO,
+      ANDROID_LOG_WARN,    ANDROID_LOG_ERROR,
+  };
+  __android_log_write(kAndroidPriorities[level], "FIREBASE-COCOS",
+                      text + prefixLength);
 #endif
-  va_end(list);
-  logTextString.append("\n");
-  logTextString.append(buffer);
-
-  // Update the log TextWidget and the ScrollView's inner container size on the
-  // Cocos2d thread.
-  cocos2d::Director::getInstance()
-      ->getScheduler()
-      ->performFunctionInCocosThread([=]() {
-        logTextWidget->setString(logTextString);
-        cocos2d::Size scrollViewContainerSize =
-            scrollView->getInnerContainerSize();
-        // Check to see if the ScrollView's inner container needs to be resized.
-        if (logTextWidget->getContentSize().height /
-                scrollViewContainerSize.height >=
-            kScrollViewContainerHeightFactor) {
-          cocos2d::Size newScrollViewContainerSize =
-              cocos2d::Size(scrollViewContainerSize.width,
-                            scrollViewContainerSize.height * 2);
-          scrollView->setInnerContainerSize(newScrollViewContainerSize);
-          scrollViewContainerSize = scrollView->getInnerContainerSize();
-        }
-        logTextWidget->setPosition(cocos2d::Point(
-            scrollViewContainerSize.width -
-                logTextWidget->getContentSize().width / 2,
-            scrollViewContainerSize.height +
-                kUIElementPadding -
-                logTextWidget->getContentSize().height / 2));
-        float scrollPercent = logTextWidget->getContentSize().height /
-                              scrollViewContainerSize.height;
-        scrollView->scrollToPercentVertical(scrollPercent * 100, 1.0, false);
-      });
+
+  // This may be running on a Firebase callback thread, so the line is handed
+  // to the Cocos2d thread through the queue. flushLog picks it up at most once
+  // per frame.
+  logQueue.push(text, static_cast<size_t>(length));
+  FirebaseFramePacer::wake();
+}
+
+void FirebaseScene::flushLog(float /*delta*/) {
+  FIREBASE_COCOS_PROFILE_SCOPE("Log flush");
+  size_t received = logQueue.drain([](const char* text, size_t length) {
+    logBuffer->append(text, length);
+  });
+  size_t dropped = logQueue.takeDroppedCount();
+  if (dropped > 0) {
+    char notice[64];
+    int length = snprintf(notice, sizeof(notice), "(%d log lines dropped)",
+                          static_cast<int>(dropped));
+    logBuffer->append(notice, static_cast<size_t>(length));
+  }
+  // binaryLog is only set on this thread, so it can be read here directly.
+  size_t binaryDropped = binaryLog ? binaryLog->takeDroppedCount() : 0;
+  if (binaryDropped > 0) {
+    char notice[64];
+    int length =
+        snprintf(notice, sizeof(notice), "(%d binary log records dropped)",
+                 static_cast<int>(binaryDropped));
+    logBuffer->append(notice, static_cast<size_t>(length));
+    dropped += binaryDropped;
+  }
+
+  if (logRowsBufferGeneration_ != logBufferGeneration) {
+    logRowsBufferGeneration_ = logBufferGeneration;
+    for (size_t i = 0; i < logRows_.size(); ++i) {
+      logRows_[i].lineNumber = kNoLogLine;
+    }
+    logViewStale_ = true;
+  }
+
+  const cocos2d::Size frameSize = scrollView_->getContentSize();
+  const float contentHeight = std::max(
+      frameSize.height, logBuffer->lineCount() * logRowHeight_);
+  if (scrollView_->getInnerContainerSize().height != contentHeight) {
+    scrollView_->setInnerContainerSize(
+        cocos2d::Size(frameSize.width, contentHeight));
+  }
+  if (received > 0 || dropped > 0 || logViewStale_) {
+    scrollView_->jumpToBottom();
+  }
+
+  // Nothing to do if the log hasn't changed and hasn't been scrolled.
+  const float offset = scrollView_->getInnerContainerPosition().y;
+  if (received == 0 && dropped == 0 && !logViewStale_ &&
+      offset == logRowsLayoutOffset_) {
+    return;
+  }
+  logViewStale_ = false;
+  logRowsLayoutOffset_ = offset;
+
+  // The inner container's origin is at its bottom left, and it is moved down
+  // by -offset as the view scrolls up, so the first visible line is the one
+  // containing the top edge of the frame.
+  const float viewTop = frameSize.height - offset;
+  const size_t firstVisibleLine = static_cast<size_t>(
+      std::max(0.0f, (contentHeight - viewTop) / logRowHeight_));
+  for (size_t i = 0; i < logRows_.size(); ++i) {
+    LogRow& row = logRows_[i];
+    const size_t index = firstVisibleLine + i;
+    if (index >= logBuffer->lineCount()) {
+      row.label->setVisible(false);
+      row.lineNumber = kNoLogLine;
+      continue;
+    }
+    // Lines keep their number until they're evicted, so rows that are still
+    // showing the same line don't need their text laid out again.
+    const size_t lineNumber = logBuffer->firstLineNumber() + index;
+    if (row.lineNumber != lineNumber) {
+      row.label->setString(logBuffer->line(index, nullptr));
+      row.lineNumber = lineNumber;
+    }
+    row.label->setPosition(
+        cocos2d::Vec2(0, contentHeight - index * logRowHeight_));
+    row.label->setVisible(true);
+  }
 }
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
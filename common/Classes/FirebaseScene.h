@@ -21,35 +21,268 @@
 #ifndef FIREBASE_COCOS_CLASSES_FIREBASE_SCENE_H_
 #define FIREBASE_COCOS_CLASSES_FIREBASE_SCENE_H_
 
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
 #include "cocos2d.h"
 #include "ui/CocosGUI.h"
 
+#include "FirebaseBinaryLog.h"
 #include "FirebaseCocos.h"
+#include "FirebaseMemoryTracker.h"
+#include "FirebaseProfiler.h"
+#include "FirebaseRequestPipeline.h"
+#include "FirebaseTrace.h"
+
+/// Marks a function as taking a printf-style format string, so the compiler can
+/// check the arguments of calls that pass a literal format. Used by
+/// FIREBASE_COCOS_CHECK_LOG_FORMAT.
+#if defined(__GNUC__) || defined(__clang__)
+#define FIREBASE_COCOS_PRINTF_FORMAT(formatIndex, firstArgIndex) \
+  __attribute__((format(printf, formatIndex, firstArgIndex)))
+#else
+#define FIREBASE_COCOS_PRINTF_FORMAT(formatIndex, firstArgIndex)
+#endif
+
+/// The log levels, from most to least verbose. These are macros so that
+/// FIREBASE_COCOS_MIN_LOG_LEVEL can be compared in the preprocessor.
+#define FIREBASE_COCOS_LOG_LEVEL_TRACE 0
+#define FIREBASE_COCOS_LOG_LEVEL_DEBUG 1
+#define FIREBASE_COCOS_LOG_LEVEL_INFO 2
+#define FIREBASE_COCOS_LOG_LEVEL_WARN 3
+#define FIREBASE_COCOS_LOG_LEVEL_ERROR 4
+
+/// The least severe level that is compiled in. Calls below it are removed,
+/// arguments and all. Defaults to TRACE in debug builds and INFO otherwise;
+/// define it in the build to override.
+#if !defined(FIREBASE_COCOS_MIN_LOG_LEVEL)
+#if defined(COCOS2D_DEBUG) && COCOS2D_DEBUG > 0
+#define FIREBASE_COCOS_MIN_LOG_LEVEL FIREBASE_COCOS_LOG_LEVEL_TRACE
+#else
+#define FIREBASE_COCOS_MIN_LOG_LEVEL FIREBASE_COCOS_LOG_LEVEL_INFO
+#endif
+#endif
+
+/// Never defined or called. Log calls name it in an unevaluated sizeof, so
+/// the compiler checks their literal format string against the arguments
+/// (-Wformat) at the call site.
+int firebaseCocosCheckLogFormat(const char* format, ...)
+    FIREBASE_COCOS_PRINTF_FORMAT(1, 2);
+
+/// Checks a log call's format and arguments at compile time without
+/// evaluating them. Yields a FirebaseScene::LogFormatChecked.
+#define FIREBASE_COCOS_CHECK_LOG_FORMAT(...)   \
+  FirebaseScene::LogFormatChecked(             \
+      sizeof(firebaseCocosCheckLogFormat(__VA_ARGS__)))
+
+/// Logs a message at the given level through `scene`, a FirebaseScene
+/// pointer. The arguments are only evaluated if the level is enabled.
+#define FIREBASE_COCOS_LOG_AT_LEVEL(scene, level, ...)                     \
+  do {                                                                     \
+    if (FirebaseScene::isLogLevelEnabled(level)) {                         \
+      (scene)->logMessageAtLevel(FIREBASE_COCOS_CHECK_LOG_FORMAT(          \
+                                     __VA_ARGS__),                         \
+                                 level, __VA_ARGS__);                      \
+    }                                                                      \
+  } while (0)
+
+/// Compiles a disabled log call without evaluating or emitting it, so the
+/// format arguments are still checked.
+#define FIREBASE_COCOS_LOG_DISABLED(scene, level, ...)                     \
+  do {                                                                     \
+    if (false) {                                                           \
+      (scene)->logMessageAtLevel(FIREBASE_COCOS_CHECK_LOG_FORMAT(          \
+                                     __VA_ARGS__),                         \
+                                 level, __VA_ARGS__);                      \
+    }                                                                      \
+  } while (0)
+
+#if FIREBASE_COCOS_MIN_LOG_LEVEL <= FIREBASE_COCOS_LOG_LEVEL_TRACE
+#define FIREBASE_COCOS_LOG_TRACE(scene, ...) \
+  FIREBASE_COCOS_LOG_AT_LEVEL(scene, FirebaseScene::kLogLevelTrace, __VA_ARGS__)
+#else
+#define FIREBASE_COCOS_LOG_TRACE(scene, ...) \
+  FIREBASE_COCOS_LOG_DISABLED(scene, FirebaseScene::kLogLevelTrace, __VA_ARGS__)
+#endif
+
+#if FIREBASE_COCOS_MIN_LOG_LEVEL <= FIREBASE_COCOS_LOG_LEVEL_DEBUG
+#define FIREBASE_COCOS_LOG_DEBUG(scene, ...) \
+  FIREBASE_COCOS_LOG_AT_LEVEL(scene, FirebaseScene::kLogLevelDebug, __VA_ARGS__)
+#else
+#define FIREBASE_COCOS_LOG_DEBUG(scene, ...) \
+  FIREBASE_COCOS_LOG_DISABLED(scene, FirebaseScene::kLogLevelDebug, __VA_ARGS__)
+#endif
+
+#if FIREBASE_COCOS_MIN_LOG_LEVEL <= FIREBASE_COCOS_LOG_LEVEL_INFO
+#define FIREBASE_COCOS_LOG_INFO(scene, ...) \
+  FIREBASE_COCOS_LOG_AT_LEVEL(scene, FirebaseScene::kLogLevelInfo, __VA_ARGS__)
+#else
+#define FIREBASE_COCOS_LOG_INFO(scene, ...) \
+  FIREBASE_COCOS_LOG_DISABLED(scene, FirebaseScene::kLogLevelInfo, __VA_ARGS__)
+#endif
+
+#if FIREBASE_COCOS_MIN_LOG_LEVEL <= FIREBASE_COCOS_LOG_LEVEL_WARN
+#define FIREBASE_COCOS_LOG_WARN(scene, ...) \
+  FIREBASE_COCOS_LOG_AT_LEVEL(scene, FirebaseScene::kLogLevelWarn, __VA_ARGS__)
+#else
+#define FIREBASE_COCOS_LOG_WARN(scene, ...) \
+  FIREBASE_COCOS_LOG_DISABLED(scene, FirebaseScene::kLogLevelWarn, __VA_ARGS__)
+#endif
+
+#if FIREBASE_COCOS_MIN_LOG_LEVEL <= FIREBASE_COCOS_LOG_LEVEL_ERROR
+#define FIREBASE_COCOS_LOG_ERROR(scene, ...) \
+  FIREBASE_COCOS_LOG_AT_LEVEL(scene, FirebaseScene::kLogLevelError, __VA_ARGS__)
+#else
+#define FIREBASE_COCOS_LOG_ERROR(scene, ...) \
+  FIREBASE_COCOS_LOG_DISABLED(scene, FirebaseScene::kLogLevelError, __VA_ARGS__)
+#endif
+
+/// True for the types that can be passed to a printf-style format: numbers,
+/// enums, pointers (including C strings) and nullptr. Class types such as
+/// std::string can't be passed through varargs.
+template <typename T>
+struct IsLogArgument
+    : std::integral_constant<
+          bool, std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+                    std::is_pointer<T>::value ||
+                    std::is_same<T, std::nullptr_t>::value> {};
+
+/// True if every type in `Args` is an IsLogArgument.
+template <typename... Args>
+struct AreLogArguments : std::true_type {};
+
+template <typename First, typename... Rest>
+struct AreLogArguments<First, Rest...>
+    : std::integral_constant<
+          bool, IsLogArgument<typename std::decay<First>::type>::value &&
+                    AreLogArguments<Rest...>::value> {};
 
 /// This factory method creates a FirebaseScene. The implementation is provided
 /// by each sample project so that it will always return the FirebaseScene
 /// associated with that sample.
 cocos2d::Scene* CreateFirebaseScene();
 
-class FirebaseScene : public cocos2d::Layer {
+class FirebaseScene : public cocos2d::Layer,
+                      public FirebaseTracked<FirebaseScene> {
  public:
+  /// Starts the scene's memory accounting. See FirebaseMemoryTracker.
+  FirebaseScene();
+
+  /// The name the scene's live objects are counted under.
+  static const char* trackedName() { return "FirebaseScene"; }
+
   /// Initialize the scene. This must be called before the scene can be
   /// interacted with or updated.
   ///
   /// @return True if the scene was initialized successfully.
   virtual bool init() = 0;
 
-  /// Update the scene. This is run once per frame.
+  /// Update the scene. This is run once per frame if the scene schedules it.
+  /// Scenes that only wait on Futures should use FirebaseCompletionDispatcher
+  /// instead and leave the update unscheduled.
   ///
   /// @param delta The number of seconds since the last update.
   virtual void update(float delta) = 0;
 
+  /// Lays out the log view again when the scene comes back to the top of the
+  /// scene stack, since other scenes may have logged while it was covered.
+  void onEnter() override;
+
   /// Called just before the app closes. This is where cleanup and shutdown
   /// logic should go.
   virtual void menuCloseAppCallback(cocos2d::Ref* pSender) = 0;
 
-  /// Updates the log text in the Firebase scene's TextWidget.
-  void logMessage(std::string format, ...);
+  /// The destinations logMessage can write to. See setLogSinks.
+  enum LogSink {
+    /// The on-screen log view and the platform log (logcat on Android).
+    kLogSinkText = 1 << 0,
+    /// The binary log file. See FirebaseBinaryLog.
+    kLogSinkBinary = 1 << 1,
+  };
+
+  /// The log levels. Prefer the FIREBASE_COCOS_LOG_* macros to logging at a
+  /// level directly, so that calls below FIREBASE_COCOS_MIN_LOG_LEVEL are
+  /// compiled out.
+  enum LogLevel {
+    kLogLevelTrace = FIREBASE_COCOS_LOG_LEVEL_TRACE,
+    kLogLevelDebug = FIREBASE_COCOS_LOG_LEVEL_DEBUG,
+    kLogLevelInfo = FIREBASE_COCOS_LOG_LEVEL_INFO,
+    kLogLevelWarn = FIREBASE_COCOS_LOG_LEVEL_WARN,
+    kLogLevelError = FIREBASE_COCOS_LOG_LEVEL_ERROR,
+  };
+
+  /// Proof that a log call's format was checked. Made only by
+  /// FIREBASE_COCOS_CHECK_LOG_FORMAT, which the logMessage macro and the
+  /// FIREBASE_COCOS_LOG_* macros pass as the first argument.
+  struct LogFormatChecked {
+    explicit LogFormatChecked(size_t) {}
+  };
+
+  /// Updates the log text in the Firebase scene's TextWidget, and writes to
+  /// any other enabled log sinks. Safe to call from any thread.
+  ///
+  /// Called as logMessage(format, ...), which the logMessage macro below
+  /// expands to pass the format check. `format` is a printf-style format
+  /// string; a literal format is checked against the arguments by -Wformat,
+  /// and passing an argument that printf can't format, such as a std::string,
+  /// fails to compile. Lines of any length are formatted into storage owned
+  /// by the calling thread, so typical lines are logged without allocating.
+  ///
+  /// The message is logged at kLogLevelInfo.
+  template <typename... Args>
+  void logMessage(LogFormatChecked checked, const char* format,
+                  const Args&... args) {
+    if (isLogLevelEnabled(kLogLevelInfo)) {
+      logMessageAtLevel(checked, kLogLevelInfo, format, args...);
+    }
+  }
+
+  /// Logs a message at `level`, which must be enabled. Called through the
+  /// FIREBASE_COCOS_LOG_* macros. See logMessage.
+  template <typename... Args>
+  void logMessageAtLevel(LogFormatChecked, LogLevel level, const char* format,
+                         const Args&... args) {
+    static_assert(AreLogArguments<Args...>::value,
+                  "logMessage arguments must be numbers, enums or pointers; "
+                  "use c_str() to log a std::string.");
+    const unsigned sinks = logSinks.load(std::memory_order_acquire);
+    if (sinks & kLogSinkBinary) binaryLog->write(level, format, args...);
+    if (sinks & kLogSinkText) logFormatted(level, format, args...);
+  }
+
+  /// Returns true if messages at `level` are compiled in and at or above the
+  /// runtime threshold. Folds to false for levels below
+  /// FIREBASE_COCOS_MIN_LOG_LEVEL.
+  static bool isLogLevelEnabled(LogLevel level) {
+    return level >= FIREBASE_COCOS_MIN_LOG_LEVEL &&
+           level >= logLevelThreshold.load(std::memory_order_relaxed);
+  }
+
+  /// Sets the least severe level that is logged. Levels below
+  /// FIREBASE_COCOS_MIN_LOG_LEVEL are never logged, whatever the threshold.
+  /// Safe to call from any thread.
+  static void setLogLevel(LogLevel level) {
+    logLevelThreshold.store(level, std::memory_order_relaxed);
+  }
+
+  /// Chooses which sinks logMessage writes to, as a mask of LogSink values.
+  /// Only kLogSinkText is enabled by default. Enabling kLogSinkBinary creates
+  /// firebase_log.bin in the app's writable directory; decode it with
+  /// tools/decode_binary_log.py. If the binary log can't be created it stays
+  /// disabled. Must be called on the Cocos2d thread.
+  static void setLogSinks(unsigned sinks);
+
+  /// Asks the OS to write the binary log back to disk, if it is enabled.
+  /// Called when a sample closes and when the app goes to the background,
+  /// since mobile apps are usually killed rather than exiting.
+  static void flushLogSinks();
+
+  /// Sets the number of lines and bytes of log text kept in memory. Once
+  /// either limit is reached the oldest lines are discarded. This clears the
+  /// current log, and must be called on the Cocos2d thread.
+  static void setLogCapacity(size_t maxLines, size_t maxBytes);
 
  protected:
   /// The Y position for a UI element.
@@ -64,9 +297,21 @@ class FirebaseScene : public cocos2d::Layer {
   cocos2d::ui::Button *createButton(
       bool buttonEnabled, const std::string& buttonTitleText);
 
+  /// Leaves the sample after its close button is tapped. This quits the app,
+  /// or in the host app (FIREBASE_COCOS_HOST_APP) returns to the host's menu.
+  /// Call it after the scene's own cleanup: it first removes the scene's
+  /// FirebaseReplay handlers, then logs the live object counts and warns
+  /// about any listeners or Futures still alive.
+  void closeSample();
+
   /// Creates a single line text entry field.
   cocos2d::ui::TextField *createTextField(const char* placeholder);
 
+  /// Creates the buttons that set `pipeline`'s in-flight limit and burst size,
+  /// each stepping through a few preset values when tapped, and a label below
+  /// them that shows the pipeline's counters while the scene runs.
+  void createRequestPipelineControls(FirebaseRequestPipeline* pipeline);
+
   /// Creates the ScrollView that contains a TextWidget for displaying log text
   /// to the user.
   ///
@@ -74,6 +319,61 @@ class FirebaseScene : public cocos2d::Layer {
   /// can be adjusted by supplying a width argument.
   void createScrollView(float yPosition);
   void createScrollView(float yPosition, float widthFraction);
+
+ private:
+  /// The enabled LogSink mask.
+  static std::atomic<unsigned> logSinks;
+
+  /// The runtime log level threshold. See setLogLevel.
+  static std::atomic<int> logLevelThreshold;
+
+  /// The binary log, created the first time kLogSinkBinary is enabled.
+  static FirebaseBinaryLog* binaryLog;
+
+  /// Logs the FirebaseMemoryTracker counts for the scene.
+  void logMemoryReport();
+
+  /// Formats a log line and hands it to the log queue. The format was
+  /// checked at the logMessage call site.
+  void logFormatted(LogLevel level, const char* format, ...);
+
+  /// Refreshes the log TextWidget if anything has been logged since the last
+  /// refresh. Scheduled to run every frame by createScrollView.
+  void flushLog(float delta);
+
+  /// A reusable row of the log view. Only enough rows to fill the ScrollView
+  /// are created; as the log scrolls they are moved and given the text of
+  /// whichever lines are visible.
+  struct LogRow {
+    cocos2d::Label* label;
+    /// The FirebaseLogBuffer line number the label is showing, or kNoLogLine.
+    size_t lineNumber;
+  };
+
+  /// The scene's log view. The log lines are shared by every scene, but each
+  /// scene draws them into its own ScrollView, so scenes stacked by the host
+  /// app never touch each other's views.
+  cocos2d::ui::ScrollView* scrollView_;
+
+  /// The log view's rows, owned by the ScrollView.
+  std::vector<LogRow> logRows_;
+
+  /// The height of a single log row.
+  float logRowHeight_;
+
+  /// The inner container offset the rows were last laid out for.
+  float logRowsLayoutOffset_;
+
+  /// The log buffer the rows' line numbers refer to. See setLogCapacity.
+  unsigned logRowsBufferGeneration_;
+
+  /// Set when the log view must be laid out even if nothing new was logged.
+  bool logViewStale_;
 };
 
+/// Lets scenes keep calling logMessage(format, ...) while routing every call
+/// through FIREBASE_COCOS_CHECK_LOG_FORMAT, where the format is a literal.
+#define logMessage(...) \
+  logMessage(FIREBASE_COCOS_CHECK_LOG_FORMAT(__VA_ARGS__), __VA_ARGS__)
+
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_SCENE_H_
@@ -0,0 +1,165 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseStartup.h"
+
+#include <chrono>
+
+#include "cocos2d.h"
+#include "FirebaseScene.h"
+#include "FirebaseTrace.h"
+
+/// The images the sample scenes use, loaded while the boot scene is showing.
+static const char* kPreloadImages[] = {
+    "NormalButtonImage.png", "SelectedButtonImage.png",
+};
+static const size_t kPreloadImageCount =
+    sizeof(kPreloadImages) / sizeof(kPreloadImages[0]);
+
+/// The text and font size of the boot scene.
+static const char kBootText[] = "Loading...";
+static const float kBootFontSize = 20.0;
+
+/// The scheduler key for the startup callbacks.
+static const char kScheduleKey[] = "FirebaseStartup";
+
+/// A timed phase of startup. Times are nanoseconds since begin().
+struct StartupPhase {
+  const char* name;
+  uint64_t start;
+  uint64_t end;
+  FirebaseTrace::Span span;
+};
+
+static const int kMaxPhases = 16;
+static StartupPhase startupPhases[kMaxPhases];
+static int startupPhaseCount = 0;
+static uint64_t startupTime = 0;
+
+/// The state of run().
+static bool appCreated = false;
+static size_t texturesPending = 0;
+static bool sceneCreated = false;
+
+/// Returns the steady clock time in nanoseconds.
+static uint64_t startupNow() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void FirebaseStartup::begin() {
+  startupTime = startupNow();
+  startupPhaseCount = 0;
+}
+
+int FirebaseStartup::beginPhase(const char* name) {
+  if (startupPhaseCount >= kMaxPhases) return -1;
+  StartupPhase& phase = startupPhases[startupPhaseCount];
+  phase.name = name;
+  phase.start = startupNow() - startupTime;
+  phase.end = 0;
+  phase.span = FirebaseTrace::begin(name);
+  return startupPhaseCount++;
+}
+
+void FirebaseStartup::endPhase(int phase) {
+  if (phase < 0) return;
+  startupPhases[phase].end = startupNow() - startupTime;
+  FirebaseTrace::end(&startupPhases[phase].span);
+}
+
+void FirebaseStartup::run(const std::function<void()>& createApp) {
+  cocos2d::Director* director = cocos2d::Director::getInstance();
+  cocos2d::Size visibleSize = director->getVisibleSize();
+  cocos2d::Vec2 origin = director->getVisibleOrigin();
+
+  // The boot scene uses a system font so that showing it doesn't wait on
+  // loading a TTF file.
+  cocos2d::Scene* boot = cocos2d::Scene::create();
+  cocos2d::Label* label =
+      cocos2d::Label::createWithSystemFont(kBootText, "Arial", kBootFontSize);
+  label->setPosition(cocos2d::Vec2(origin.x + visibleSize.width / 2,
+                                   origin.y + visibleSize.height / 2));
+  boot->addChild(label);
+  const int firstFrame = beginPhase("First frame");
+  director->runWithScene(boot);
+
+  // The texture cache decodes images on its own thread and calls back on the
+  // cocos thread.
+  const int preload = beginPhase("Texture preload");
+  texturesPending = kPreloadImageCount;
+  for (size_t i = 0; i < kPreloadImageCount; ++i) {
+    director->getTextureCache()->addImageAsync(
+        kPreloadImages[i], [preload](cocos2d::Texture2D* /*texture*/) {
+          if (--texturesPending == 0) {
+            endPhase(preload);
+            createSceneIfReady();
+          }
+        });
+  }
+
+  // A boot scene callback first runs on the frame after the boot scene is
+  // drawn, so the app is created once the first frame is on screen.
+  boot->scheduleOnce(
+      [firstFrame, createApp](float /*delta*/) {
+        endPhase(firstFrame);
+        const int create = beginPhase("firebase::App::Create");
+        createApp();
+        endPhase(create);
+        appCreated = true;
+        createSceneIfReady();
+      },
+      0, kScheduleKey);
+}
+
+void FirebaseStartup::createSceneIfReady() {
+  if (!appCreated || texturesPending > 0 || sceneCreated) return;
+  sceneCreated = true;
+
+  const int create = beginPhase("Scene creation");
+  cocos2d::Scene* scene = CreateFirebaseScene();
+  endPhase(create);
+  cocos2d::Director::getInstance()->replaceScene(scene);
+
+  const int firstFrame = beginPhase("First sample frame");
+  scene->scheduleOnce(
+      [firstFrame](float /*delta*/) {
+        endPhase(firstFrame);
+        report();
+      },
+      0, kScheduleKey);
+}
+
+void FirebaseStartup::report() {
+  // cocos2d::log rather than CCLOG, so the report is also logged in release
+  // builds.
+  cocos2d::log("Startup phases (ms since launch: start - end = duration):");
+  for (int i = 0; i < startupPhaseCount; ++i) {
+    const StartupPhase& phase = startupPhases[i];
+    if (phase.end == 0) {
+      cocos2d::log("  %s: %.1f - unfinished", phase.name, phase.start / 1e6);
+      continue;
+    }
+    cocos2d::log("  %s: %.1f - %.1f = %.1f", phase.name, phase.start / 1e6,
+                 phase.end / 1e6, (phase.end - phase.start) / 1e6);
+  }
+}
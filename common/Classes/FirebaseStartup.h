@@ -0,0 +1,66 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_STARTUP_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_STARTUP_H_
+
+#include <stdint.h>
+
+#include <functional>
+
+/// Orders the work done at app launch so the first frame is shown as early as
+/// possible, and times each phase of startup.
+///
+/// run() shows a minimal boot scene straight away. While it is on screen the
+/// sample's textures are loaded on the texture cache's loader thread, and in
+/// parallel the Firebase app is created on the cocos thread. The sample scene
+/// is created once both have finished. When the sample scene draws its first
+/// frame the phase timings are logged and the startup is done.
+///
+/// Phases are also recorded as FirebaseTrace spans. All methods must be called
+/// on the cocos thread.
+class FirebaseStartup {
+ public:
+  /// Starts the startup clock. Call first thing in
+  /// applicationDidFinishLaunching.
+  static void begin();
+
+  /// Begins timing a phase called `name`, which must be a string literal, and
+  /// returns its id.
+  static int beginPhase(const char* name);
+
+  /// Ends the phase `phase`.
+  static void endPhase(int phase);
+
+  /// Shows the boot scene, then calls `createApp` to create the Firebase app
+  /// and shows the sample scene. `createApp` runs on the cocos thread after
+  /// the first frame.
+  static void run(const std::function<void()>& createApp);
+
+  /// Logs the time taken by each phase.
+  static void report();
+
+ private:
+  /// Creates and shows the sample scene once the app is created and the
+  /// textures are loaded.
+  static void createSceneIfReady();
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_STARTUP_H_
@@ -0,0 +1,192 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseTrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+
+/// The number of events the trace can hold. Later events are dropped.
+static const size_t kMaxEvents = 64 * 1024;
+
+/// A recorded trace event.
+struct TraceEvent {
+  const char* name;
+  uint64_t id;
+  uint64_t timestamp;
+  uint32_t thread;
+  /// The Chrome trace phase: 'b' and 'e' for async begin and end, 'i' for an
+  /// instant.
+  char phase;
+  /// Whether the event belongs to a delivery span.
+  bool delivery;
+  /// Set once the event has been filled in.
+  std::atomic<bool> ready;
+};
+
+/// The event buffer, allocated by start(). Never freed, since other threads
+/// may still be writing to it when finish() runs.
+static TraceEvent* traceEvents = nullptr;
+static std::atomic<size_t> traceEventCount(0);
+static std::atomic<bool> traceRecording(false);
+static std::atomic<bool> traceStarted(false);
+static std::atomic<uint64_t> traceNextSpanId(1);
+static std::atomic<uint32_t> traceNextThread(1);
+static uint64_t traceStartTime = 0;
+static std::string* tracePath = nullptr;
+
+/// Returns the steady clock time in nanoseconds.
+static uint64_t traceNow() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+/// Returns a small number identifying the calling thread.
+static uint32_t traceThread() {
+  static thread_local uint32_t thread = 0;
+  if (!thread) {
+    thread = traceNextThread.fetch_add(1, std::memory_order_relaxed);
+  }
+  return thread;
+}
+
+/// Appends an event, if recording and there is room.
+static void traceRecord(char phase, const char* name, uint64_t id,
+                        bool delivery) {
+  if (!traceRecording.load(std::memory_order_acquire)) return;
+  const size_t index = traceEventCount.fetch_add(1, std::memory_order_relaxed);
+  if (index >= kMaxEvents) return;
+  TraceEvent& event = traceEvents[index];
+  event.name = name;
+  event.id = id;
+  event.timestamp = traceNow();
+  event.thread = traceThread();
+  event.phase = phase;
+  event.delivery = delivery;
+  event.ready.store(true, std::memory_order_release);
+}
+
+/// Writes `text` to `file` as a JSON string.
+static void writeJsonString(FILE* file, const char* text) {
+  fputc('"', file);
+  for (const char* c = text; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+      fputc(*c, file);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      fprintf(file, "\\u%04x", *c);
+    } else {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+/// Runs finish() at exit.
+static void finishAtExit() { FirebaseTrace::finish(); }
+
+bool FirebaseTrace::start(const std::string& path) {
+  bool expected = false;
+  if (!traceStarted.compare_exchange_strong(expected, true)) return false;
+  traceEvents = new TraceEvent[kMaxEvents];
+  for (size_t i = 0; i < kMaxEvents; ++i) {
+    traceEvents[i].ready.store(false, std::memory_order_relaxed);
+  }
+  tracePath = new std::string(path);
+  traceStartTime = traceNow();
+  atexit(finishAtExit);
+  traceRecording.store(true, std::memory_order_release);
+  return true;
+}
+
+bool FirebaseTrace::isRecording() {
+  return traceRecording.load(std::memory_order_acquire);
+}
+
+FirebaseTrace::Span FirebaseTrace::begin(const char* name) {
+  Span span;
+  // The name is kept even when not recording, for FirebaseReplay.
+  span.name = name;
+  if (!isRecording()) return span;
+  span.id = traceNextSpanId.fetch_add(1, std::memory_order_relaxed);
+  traceRecord('b', name, span.id, false);
+  return span;
+}
+
+void FirebaseTrace::end(Span* span) {
+  if (span->id) traceRecord('e', span->name, span->id, span->delivery);
+  *span = Span();
+}
+
+FirebaseTrace::Span FirebaseTrace::handOff(Span* span) {
+  Span delivery;
+  if (span->id && isRecording()) {
+    delivery.id = traceNextSpanId.fetch_add(1, std::memory_order_relaxed);
+    delivery.name = span->name;
+    delivery.delivery = true;
+  }
+  end(span);
+  if (delivery.id) traceRecord('b', delivery.name, delivery.id, true);
+  return delivery;
+}
+
+void FirebaseTrace::instant(const char* name) {
+  traceRecord('i', name, 0, false);
+}
+
+void FirebaseTrace::finish() {
+  bool expected = true;
+  if (!traceRecording.compare_exchange_strong(expected, false)) return;
+
+  FILE* file = fopen(tracePath->c_str(), "w");
+  if (!file) return;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+  size_t count = traceEventCount.load(std::memory_order_acquire);
+  if (count > kMaxEvents) count = kMaxEvents;
+  bool first = true;
+  for (size_t i = 0; i < count; ++i) {
+    const TraceEvent& event = traceEvents[i];
+    // Skip events another thread was still writing.
+    if (!event.ready.load(std::memory_order_acquire)) continue;
+    fputs(first ? "\n{" : ",\n{", file);
+    first = false;
+    fputs("\"name\":", file);
+    writeJsonString(file, event.name);
+    fprintf(file,
+            ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,"
+            "\"tid\":%u",
+            event.delivery ? "delivery" : "firebase", event.phase,
+            (event.timestamp - traceStartTime) / 1000.0, event.thread);
+    if (event.phase == 'i') {
+      fputs(",\"s\":\"p\"", file);
+    } else {
+      fprintf(file, ",\"id\":\"0x%llx\"",
+              static_cast<unsigned long long>(event.id));
+    }
+    fputc('}', file);
+  }
+  fputs("\n]}\n", file);
+  fclose(file);
+}
@@ -0,0 +1,82 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_TRACE_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_TRACE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+/// Records the lifetime of Firebase operations as spans in a Chrome
+/// trace_event JSON file, which can be loaded into chrome://tracing or
+/// Perfetto.
+///
+/// A span begins when an operation's Future is created and ends on whichever
+/// thread completes it, so it covers the request latency alone. The wait
+/// until the scene's callback runs on the cocos thread is recorded as a
+/// second span of the same name under the "delivery" category; see
+/// handOff(). Spans are recorded as async events, so overlapping operations
+/// show up side by side.
+///
+/// Recording is off until start() is called. Events are appended to a
+/// preallocated buffer with a single atomic add, so begin() and end() may be
+/// called from any thread. The file is written by finish(), which start()
+/// also arranges to run when the process exits.
+class FirebaseTrace {
+ public:
+  /// An operation in progress. A default constructed Span, or one begun while
+  /// recording was off, is inactive and ending it does nothing.
+  struct Span {
+    Span() : id(0), name(nullptr), delivery(false) {}
+
+    uint64_t id;
+    const char* name;
+    /// Whether this is the delivery span begun by handOff().
+    bool delivery;
+  };
+
+  /// Starts recording. The trace is written to `path` by finish(). Returns
+  /// false if recording was already started.
+  static bool start(const std::string& path);
+
+  /// Stops recording and writes the trace file. Does nothing if recording
+  /// isn't on.
+  static void finish();
+
+  /// Returns true while recording.
+  static bool isRecording();
+
+  /// Begins a span called `name`, which must be a string literal.
+  static Span begin(const char* name);
+
+  /// Ends `span` and makes it inactive.
+  static void end(Span* span);
+
+  /// Ends `span` when its operation completes and begins the span of handing
+  /// the result to the cocos thread, which is returned. End that one when the
+  /// callback runs there.
+  static Span handOff(Span* span);
+
+  /// Records a point in time, such as the moment a callback fired.
+  static void instant(const char* name);
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_TRACE_H_
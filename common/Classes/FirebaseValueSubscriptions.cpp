@@ -0,0 +1,220 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseValueSubscriptions.h"
+
+#include <memory>
+
+#include "cocos2d.h"
+#include "FirebaseLocalBackend.h"
+#include "FirebaseMemoryTracker.h"
+
+/// The ValueListener shared by the subscribers of a path.
+///
+/// A callback may already be running on an SDK thread when the listener is
+/// removed, so detach() first disconnects it, which waits for any callback
+/// inside the subscriptions to return, and deletes it on a later frame.
+class FirebaseValueSubscriptions::PathListener
+    : public firebase::database::ValueListener {
+ public:
+  PathListener(FirebaseValueSubscriptions* subscriptions,
+               const std::string& path)
+      : subscriptions_(subscriptions), path_(path), attached_(new Attached) {}
+
+  void OnValueChanged(
+      const firebase::database::DataSnapshot& snapshot) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!subscriptions_) return;
+    subscriptions_->deliverValue(path_, snapshot.key(), snapshot.value());
+  }
+
+  void OnCancelled(const firebase::database::Error& error,
+                   const char* error_message) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!subscriptions_) return;
+    subscriptions_->deliverCancelled(path_, error, error_message);
+  }
+
+  /// Stops passing callbacks on. Once this returns no callback is using the
+  /// subscriptions, and the listener no longer counts as attached.
+  void disconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscriptions_ = nullptr;
+    attached_.reset();
+  }
+
+ private:
+  /// Counts the listeners added to the database and not yet detached.
+  struct Attached : FirebaseTracked<Attached, true> {
+    static const char* trackedName() { return "shared ValueListener"; }
+  };
+
+  /// Held while a callback runs. Taken before the subscriptions' mutex.
+  std::mutex mutex_;
+  FirebaseValueSubscriptions* subscriptions_;
+  std::string path_;
+  std::unique_ptr<Attached> attached_;
+};
+
+FirebaseValueSubscriptions::FirebaseValueSubscriptions() : nextId_(1) {}
+
+FirebaseValueSubscriptions::~FirebaseValueSubscriptions() {
+  unsubscribeAll();
+}
+
+int FirebaseValueSubscriptions::subscribe(
+    firebase::database::Database* database, const std::string& path,
+    const ValueCallback& onValue, const CancelledCallback& onCancelled) {
+  Subscriber subscriber;
+  subscriber.onValue = onValue;
+  subscriber.onCancelled = onCancelled;
+  bool needsListener;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscriber.id = nextId_++;
+    Path& state = paths_[path];
+    needsListener = state.subscribers.empty();
+    state.subscribers.push_back(subscriber);
+    subscriptionPaths_[subscriber.id] = path;
+    if (state.cancelled) {
+      onCancelled(state.error, state.errorMessage.c_str());
+    } else if (state.hasValue) {
+      onValue(state.key.c_str(), state.value);
+    }
+  }
+  if (needsListener) {
+    // Only the cocos thread adds or removes paths, so the path is still here.
+    const Listener listener = attach(database, path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    paths_[path].listener = listener;
+  }
+  return subscriber.id;
+}
+
+void FirebaseValueSubscriptions::unsubscribe(int id) {
+  Listener listener;
+  bool lastSubscriber = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, std::string>::iterator found = subscriptionPaths_.find(id);
+    if (found == subscriptionPaths_.end()) return;
+    std::map<std::string, Path>::iterator path = paths_.find(found->second);
+    subscriptionPaths_.erase(found);
+    std::vector<Subscriber>& subscribers = path->second.subscribers;
+    for (size_t i = 0; i < subscribers.size(); ++i) {
+      if (subscribers[i].id == id) {
+        subscribers.erase(subscribers.begin() + i);
+        break;
+      }
+    }
+    if (subscribers.empty()) {
+      listener = path->second.listener;
+      lastSubscriber = true;
+      paths_.erase(path);
+    }
+  }
+  if (lastSubscriber) detach(listener);
+}
+
+void FirebaseValueSubscriptions::unsubscribeAll() {
+  std::vector<Listener> listeners;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::map<std::string, Path>::iterator it = paths_.begin();
+         it != paths_.end(); ++it) {
+      listeners.push_back(it->second.listener);
+    }
+    paths_.clear();
+    subscriptionPaths_.clear();
+  }
+  for (size_t i = 0; i < listeners.size(); ++i) detach(listeners[i]);
+}
+
+size_t FirebaseValueSubscriptions::getListenerCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return paths_.size();
+}
+
+size_t FirebaseValueSubscriptions::getSubscriberCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return subscriptionPaths_.size();
+}
+
+void FirebaseValueSubscriptions::deliverValue(const std::string& path,
+                                              const char* key,
+                                              const firebase::Variant& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, Path>::iterator found = paths_.find(path);
+  if (found == paths_.end()) return;
+  Path& state = found->second;
+  state.hasValue = true;
+  state.key = key ? key : "";
+  state.value = value;
+  for (size_t i = 0; i < state.subscribers.size(); ++i) {
+    state.subscribers[i].onValue(state.key.c_str(), value);
+  }
+}
+
+void FirebaseValueSubscriptions::deliverCancelled(const std::string& path,
+                                                  int error,
+                                                  const char* errorMessage) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, Path>::iterator found = paths_.find(path);
+  if (found == paths_.end()) return;
+  Path& state = found->second;
+  state.cancelled = true;
+  state.error = error;
+  state.errorMessage = errorMessage ? errorMessage : "";
+  for (size_t i = 0; i < state.subscribers.size(); ++i) {
+    state.subscribers[i].onCancelled(error, state.errorMessage.c_str());
+  }
+}
+
+FirebaseValueSubscriptions::Listener FirebaseValueSubscriptions::attach(
+    firebase::database::Database* database, const std::string& path) {
+  Listener listener;
+  if (!database) {
+    listener.localId = FirebaseLocalBackend::addValueListener(
+        path, [this, path](const char* key, const firebase::Variant& value) {
+          deliverValue(path, key, value);
+        });
+    return listener;
+  }
+  listener.reference = database->GetReference(path.c_str());
+  listener.listener = new PathListener(this, path);
+  listener.reference.AddValueListener(listener.listener);
+  return listener;
+}
+
+void FirebaseValueSubscriptions::detach(Listener listener) {
+  if (listener.listener) {
+    PathListener* pathListener = listener.listener;
+    listener.reference.RemoveValueListener(pathListener);
+    pathListener->disconnect();
+    // A callback that found the listener disconnected may still be returning,
+    // so the listener is deleted on a later frame rather than here.
+    cocos2d::Director::getInstance()
+        ->getScheduler()
+        ->performFunctionInCocosThread(
+            [pathListener]() { delete pathListener; });
+  } else if (listener.localId != 0) {
+    FirebaseLocalBackend::removeValueListener(listener.localId);
+  }
+}
@@ -0,0 +1,134 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_VALUE_SUBSCRIPTIONS_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_VALUE_SUBSCRIPTIONS_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "firebase/database.h"
+#include "firebase/variant.h"
+
+/// Shares one database ValueListener per path between any number of local
+/// subscribers, so listening to a path twice doesn't make the server send
+/// every change twice.
+///
+/// The first subscriber to a path adds its listener and the last one to
+/// leave removes it. Each value the listener receives is passed to every
+/// subscriber of the path, and a new subscriber to a path that already has a
+/// value is given it straight away, as a new listener would be. If the
+/// listener is cancelled, every subscriber is told, and so is any later one
+/// until the path has no subscribers left.
+///
+/// subscribe() and unsubscribe() must be called on the cocos thread.
+/// Subscribers are called on the listener's thread, one at a time, and never
+/// after unsubscribe() has returned; they must not subscribe or unsubscribe.
+/// A removed database listener is deleted on a later frame, once no callback
+/// can still be running in it.
+class FirebaseValueSubscriptions {
+ public:
+  /// Called with the key and value of the path on each change.
+  typedef std::function<void(const char* key, const firebase::Variant& value)>
+      ValueCallback;
+
+  /// Called with the SDK error if the path's listener is cancelled.
+  typedef std::function<void(int error, const char* errorMessage)>
+      CancelledCallback;
+
+  FirebaseValueSubscriptions();
+
+  /// Unsubscribes everyone.
+  ~FirebaseValueSubscriptions();
+
+  /// Subscribes to the value at `path`, and returns the subscription's id.
+  /// The path's listener is added through `database`, or to
+  /// FirebaseLocalBackend if `database` is null.
+  int subscribe(firebase::database::Database* database,
+                const std::string& path, const ValueCallback& onValue,
+                const CancelledCallback& onCancelled);
+
+  /// Ends the subscription `id`. Unknown ids are ignored.
+  void unsubscribe(int id);
+
+  /// Ends every subscription.
+  void unsubscribeAll();
+
+  /// Returns the number of listeners and of subscribers.
+  size_t getListenerCount() const;
+  size_t getSubscriberCount() const;
+
+ private:
+  class PathListener;
+
+  struct Subscriber {
+    int id;
+    ValueCallback onValue;
+    CancelledCallback onCancelled;
+  };
+
+  /// A path's listener, which is either a PathListener on `reference` or a
+  /// FirebaseLocalBackend listener.
+  struct Listener {
+    Listener() : listener(nullptr), localId(0) {}
+
+    firebase::database::DatabaseReference reference;
+    PathListener* listener;
+    int localId;
+  };
+
+  struct Path {
+    Path() : hasValue(false), cancelled(false), error(0) {}
+
+    std::vector<Subscriber> subscribers;
+    Listener listener;
+    bool hasValue;
+    std::string key;
+    firebase::Variant value;
+    bool cancelled;
+    int error;
+    std::string errorMessage;
+  };
+
+  /// Passes a listener callback on to the subscribers of `path`.
+  void deliverValue(const std::string& path, const char* key,
+                    const firebase::Variant& value);
+  void deliverCancelled(const std::string& path, int error,
+                        const char* errorMessage);
+
+  /// Adds and removes a path's listener. Called without mutex_ held, since
+  /// the listener may be called while they run.
+  Listener attach(firebase::database::Database* database,
+                  const std::string& path);
+  static void detach(Listener listener);
+
+  /// Guards the members below, and is held while subscribers are called.
+  mutable std::mutex mutex_;
+  std::map<std::string, Path> paths_;
+  std::map<int, std::string> subscriptionPaths_;
+  int nextId_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_VALUE_SUBSCRIPTIONS_H_
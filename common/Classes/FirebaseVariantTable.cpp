@@ -0,0 +1,227 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseVariantTable.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/// The initial size of the key hash table. Always a power of two.
+static const size_t kInitialKeyBuckets = 64;
+
+/// Returns the FNV-1a hash of `length` bytes at `data`.
+static uint32_t hashBytes(const char* data, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+FirebaseVariantTable::FirebaseVariantTable()
+    : keyBuckets_(kInitialKeyBuckets, 0), maxDepth_(0) {}
+
+void FirebaseVariantTable::clear() {
+  nodes_.clear();
+  arena_.clear();
+  keys_.clear();
+  keyBuckets_.assign(keyBuckets_.size(), 0);
+  maxDepth_ = 0;
+}
+
+void FirebaseVariantTable::decode(const firebase::Variant& value) {
+  clear();
+  addNode(value, kNoKey, 0);
+  // Nodes are appended in breadth first order, so the node array doubles as
+  // the queue of nodes whose children haven't been added yet.
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const firebase::Variant& source = *sources_[i];
+    const uint32_t depth = nodes_[i].depth + 1;
+    if (source.is_map()) {
+      const std::map<firebase::Variant, firebase::Variant>& map = source.map();
+      nodes_[i].firstChild = static_cast<uint32_t>(nodes_.size());
+      nodes_[i].childCount = static_cast<uint32_t>(map.size());
+      for (std::map<firebase::Variant, firebase::Variant>::const_iterator it =
+               map.begin();
+           it != map.end(); ++it) {
+        addNode(it->second, internMapKey(it->first), depth);
+      }
+    } else if (source.is_vector()) {
+      const std::vector<firebase::Variant>& vector = source.vector();
+      nodes_[i].firstChild = static_cast<uint32_t>(nodes_.size());
+      nodes_[i].childCount = static_cast<uint32_t>(vector.size());
+      for (size_t j = 0; j < vector.size(); ++j) {
+        addNode(vector[j], kNoKey, depth);
+      }
+    }
+  }
+  sources_.clear();
+}
+
+void FirebaseVariantTable::addNode(const firebase::Variant& value,
+                                   uint32_t key, uint32_t depth) {
+  Node node;
+  node.key = key;
+  node.depth = depth;
+  node.firstChild = 0;
+  node.childCount = 0;
+  node.value.int64Value = 0;
+  switch (value.type()) {
+    case firebase::Variant::kTypeInt64:
+      node.type = kNodeInt64;
+      node.value.int64Value = value.int64_value();
+      break;
+    case firebase::Variant::kTypeDouble:
+      node.type = kNodeDouble;
+      node.value.doubleValue = value.double_value();
+      break;
+    case firebase::Variant::kTypeBool:
+      node.type = kNodeBool;
+      node.value.int64Value = value.bool_value() ? 1 : 0;
+      break;
+    case firebase::Variant::kTypeStaticString:
+    case firebase::Variant::kTypeMutableString: {
+      node.type = kNodeString;
+      const char* string = value.string_value();
+      node.value.bytes = store(string, string ? strlen(string) : 0);
+      break;
+    }
+    case firebase::Variant::kTypeStaticBlob:
+    case firebase::Variant::kTypeMutableBlob:
+      node.type = kNodeBlob;
+      node.value.bytes = store(value.blob_data(), value.blob_size());
+      break;
+    case firebase::Variant::kTypeMap:
+      node.type = kNodeMap;
+      break;
+    case firebase::Variant::kTypeVector:
+      node.type = kNodeVector;
+      break;
+    default:
+      node.type = kNodeNull;
+  }
+  if (depth > maxDepth_) maxDepth_ = depth;
+  nodes_.push_back(node);
+  sources_.push_back(&value);
+}
+
+FirebaseVariantTable::Bytes FirebaseVariantTable::store(const void* data,
+                                                        size_t size) {
+  Bytes bytes;
+  bytes.offset = static_cast<uint32_t>(arena_.size());
+  bytes.length = static_cast<uint32_t>(size);
+  const char* begin = static_cast<const char*>(data);
+  if (size > 0) arena_.insert(arena_.end(), begin, begin + size);
+  arena_.push_back('\0');
+  return bytes;
+}
+
+size_t FirebaseVariantTable::keyBucket(const char* key, size_t length) const {
+  const size_t mask = keyBuckets_.size() - 1;
+  size_t bucket = hashBytes(key, length) & mask;
+  for (;;) {
+    const uint32_t entry = keyBuckets_[bucket];
+    if (entry == 0) return bucket;
+    const Bytes& existing = keys_[entry - 1];
+    if (existing.length == length &&
+        memcmp(&arena_[existing.offset], key, length) == 0) {
+      return bucket;
+    }
+    bucket = (bucket + 1) & mask;
+  }
+}
+
+uint32_t FirebaseVariantTable::findKey(const char* key, size_t length) const {
+  const uint32_t entry = keyBuckets_[keyBucket(key, length)];
+  return entry == 0 ? kNoKey : entry - 1;
+}
+
+uint32_t FirebaseVariantTable::intern(const char* key, size_t length) {
+  const size_t bucket = keyBucket(key, length);
+  if (keyBuckets_[bucket] != 0) return keyBuckets_[bucket] - 1;
+  const uint32_t id = static_cast<uint32_t>(keys_.size());
+  keys_.push_back(store(key, length));
+  keyBuckets_[bucket] = id + 1;
+  // Keep the table at most half full, so probe runs stay short.
+  if (keys_.size() * 2 > keyBuckets_.size()) growKeyBuckets();
+  return id;
+}
+
+void FirebaseVariantTable::growKeyBuckets() {
+  keyBuckets_.assign(keyBuckets_.size() * 2, 0);
+  const size_t mask = keyBuckets_.size() - 1;
+  for (uint32_t id = 0; id < keys_.size(); ++id) {
+    size_t bucket = hashBytes(&arena_[keys_[id].offset], keys_[id].length) &
+                    mask;
+    while (keyBuckets_[bucket] != 0) bucket = (bucket + 1) & mask;
+    keyBuckets_[bucket] = id + 1;
+  }
+}
+
+uint32_t FirebaseVariantTable::internMapKey(const firebase::Variant& key) {
+  if (key.is_string()) {
+    const char* string = key.string_value();
+    return intern(string ? string : "", string ? strlen(string) : 0);
+  }
+  // Database keys are strings, but a Variant map may have other keys.
+  if (key.type() == firebase::Variant::kTypeInt64) {
+    char number[32];
+    const int length = snprintf(number, sizeof(number), "%lld",
+                                static_cast<long long>(key.int64_value()));
+    return intern(number, static_cast<size_t>(length));
+  }
+  const firebase::Variant string = key.AsString();
+  const char* value = string.string_value();
+  return intern(value ? value : "", value ? strlen(value) : 0);
+}
+
+const char* FirebaseVariantTable::View::key() const {
+  const uint32_t key = node().key;
+  if (key == kNoKey) return nullptr;
+  return &table_->arena_[table_->keys_[key].offset];
+}
+
+const char* FirebaseVariantTable::View::stringValue() const {
+  return &table_->arena_[node().value.bytes.offset];
+}
+
+const uint8_t* FirebaseVariantTable::View::blobData() const {
+  return reinterpret_cast<const uint8_t*>(
+      &table_->arena_[node().value.bytes.offset]);
+}
+
+FirebaseVariantTable::View FirebaseVariantTable::View::child(
+    size_t index) const {
+  return View(table_, node().firstChild + static_cast<uint32_t>(index));
+}
+
+FirebaseVariantTable::View FirebaseVariantTable::View::find(
+    const char* key) const {
+  const uint32_t id = table_->findKey(key, strlen(key));
+  if (id == kNoKey) return View(nullptr, 0);
+  const Node& parent = node();
+  for (uint32_t i = 0; i < parent.childCount; ++i) {
+    if (table_->nodes_[parent.firstChild + i].key == id) {
+      return View(table_, parent.firstChild + i);
+    }
+  }
+  return View(nullptr, 0);
+}
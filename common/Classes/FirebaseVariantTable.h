@@ -0,0 +1,181 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_VARIANT_TABLE_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_VARIANT_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "firebase/variant.h"
+
+/// A flat, read-only copy of a Variant tree, such as a DataSnapshot's value,
+/// that can be walked without touching the Variants again.
+///
+/// decode() walks the tree breadth first with a loop rather than recursion,
+/// so deeply nested values can't overflow the stack. Each node becomes an
+/// entry in one node array, with the children of a map or vector stored next
+/// to each other. String values and blobs are copied into a single byte
+/// arena, and map keys are interned there once however many nodes share
+/// them. The arrays keep their capacity between decodes, so decoding values
+/// of a similar size again doesn't allocate.
+///
+/// Views are small handles onto a node. They, and the pointers they return,
+/// are only valid until the next decode() or clear().
+class FirebaseVariantTable {
+ public:
+  /// The type of a node. Static and mutable strings and blobs are not told
+  /// apart.
+  enum NodeType {
+    kNodeNull,
+    kNodeInt64,
+    kNodeDouble,
+    kNodeBool,
+    kNodeString,
+    kNodeBlob,
+    kNodeMap,
+    kNodeVector,
+  };
+
+  /// A typed view of one node. See below.
+  class View;
+
+  FirebaseVariantTable();
+
+  /// Replaces the table's contents with a copy of `value`.
+  void decode(const firebase::Variant& value);
+
+  /// Empties the table, keeping its storage.
+  void clear();
+
+  /// Returns the root node. The table must not be empty.
+  View root() const;
+
+  /// The number of nodes and of distinct keys, the depth of the deepest node
+  /// (the root is at depth 0), and the bytes held by the arena.
+  size_t nodeCount() const { return nodes_.size(); }
+  size_t keyCount() const { return keys_.size(); }
+  size_t maxDepth() const { return maxDepth_; }
+  size_t arenaSize() const { return arena_.size(); }
+
+ private:
+  /// Marks a node without a key.
+  static const uint32_t kNoKey = 0xffffffff;
+
+  /// A run of bytes in the arena.
+  struct Bytes {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  struct Node {
+    NodeType type;
+    uint32_t key;
+    uint32_t depth;
+    uint32_t firstChild;
+    uint32_t childCount;
+    union {
+      int64_t int64Value;
+      double doubleValue;
+      Bytes bytes;
+    } value;
+  };
+
+  /// Appends a node for `value`, which is not decoded into yet.
+  void addNode(const firebase::Variant& value, uint32_t key, uint32_t depth);
+
+  /// Copies `size` bytes into the arena, followed by a terminator.
+  Bytes store(const void* data, size_t size);
+
+  /// Returns the hash bucket that holds the key `key`, or the empty bucket
+  /// where it would go.
+  size_t keyBucket(const char* key, size_t length) const;
+
+  /// Returns the id of the key `key`, or kNoKey if it isn't interned.
+  uint32_t findKey(const char* key, size_t length) const;
+
+  /// Returns the id of the key `key`, adding it if it is new.
+  uint32_t intern(const char* key, size_t length);
+
+  /// Doubles the key hash table and rehashes the keys.
+  void growKeyBuckets();
+
+  /// Returns the interned id of a map key, which is usually a string.
+  uint32_t internMapKey(const firebase::Variant& key);
+
+  std::vector<Node> nodes_;
+  /// The Variant each node was made from, valid only during decode().
+  std::vector<const firebase::Variant*> sources_;
+  std::vector<char> arena_;
+  /// The interned keys, and an open addressing hash table of their ids + 1.
+  std::vector<Bytes> keys_;
+  std::vector<uint32_t> keyBuckets_;
+  size_t maxDepth_;
+};
+
+/// A typed view of one node.
+class FirebaseVariantTable::View {
+ public:
+  /// Returns false for the view find() returns when there is no match.
+  bool isValid() const { return table_ != nullptr; }
+
+  NodeType type() const { return node().type; }
+
+  /// The node's key in its parent map, or null for the root and vector
+  /// elements.
+  const char* key() const;
+
+  /// The node's value. Each must only be called for nodes of its type.
+  int64_t int64Value() const { return node().value.int64Value; }
+  double doubleValue() const { return node().value.doubleValue; }
+  bool boolValue() const { return node().value.int64Value != 0; }
+  const char* stringValue() const;
+  const uint8_t* blobData() const;
+  /// The length of a string value or blob in bytes.
+  size_t size() const { return node().value.bytes.length; }
+
+  /// The children of a map or vector. Other nodes have none.
+  size_t childCount() const { return node().childCount; }
+  View child(size_t index) const;
+
+  /// Returns the child of a map with the key `key`, or an invalid view.
+  /// Linear in the number of children, but compares interned key ids
+  /// rather than strings.
+  View find(const char* key) const;
+
+ private:
+  friend class FirebaseVariantTable;
+
+  View(const FirebaseVariantTable* table, uint32_t index)
+      : table_(table), index_(index) {}
+
+  const Node& node() const { return table_->nodes_[index_]; }
+
+  const FirebaseVariantTable* table_;
+  uint32_t index_;
+};
+
+inline FirebaseVariantTable::View FirebaseVariantTable::root() const {
+  return View(this, 0);
+}
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_VARIANT_TABLE_H_
@@ -0,0 +1,122 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseWriteBatcher.h"
+
+#include <memory>
+
+#include "cocos2d.h"
+
+/// The scheduler key for the batch window.
+static const char kScheduleKey[] = "FirebaseWriteBatcher";
+
+/// Returns true if `ancestor` is a proper ancestor of `path`.
+static bool isAncestor(const std::string& ancestor, const std::string& path) {
+  return path.size() > ancestor.size() && path[ancestor.size()] == '/' &&
+         path.compare(0, ancestor.size(), ancestor) == 0;
+}
+
+FirebaseWriteBatcher::FirebaseWriteBatcher(const Writer& writer,
+                                           float windowSeconds,
+                                           size_t maxBatchSize)
+    : writer_(writer),
+      windowSeconds_(windowSeconds),
+      maxBatchSize_(maxBatchSize > 0 ? maxBatchSize : 1),
+      scheduled_(false),
+      stats_() {}
+
+FirebaseWriteBatcher::~FirebaseWriteBatcher() {
+  if (scheduled_) {
+    cocos2d::Director::getInstance()->getScheduler()->unschedule(kScheduleKey,
+                                                                 this);
+  }
+}
+
+void FirebaseWriteBatcher::setValue(const std::string& path,
+                                    const firebase::Variant& value,
+                                    const Callback& callback) {
+  if (overlapsBatch(path)) flush();
+  ++stats_.writes;
+  std::pair<Updates::iterator, bool> inserted =
+      updates_.insert(std::make_pair(path, value));
+  if (!inserted.second) {
+    inserted.first->second = value;
+    ++stats_.coalesced;
+  }
+  callbacks_.push_back(callback);
+
+  if (updates_.size() >= maxBatchSize_) {
+    flush();
+  } else if (!scheduled_) {
+    // Node::scheduleOnce's form: no interval, no repeats, after a delay.
+    scheduled_ = true;
+    cocos2d::Director::getInstance()->getScheduler()->schedule(
+        [this](float /*delta*/) {
+          scheduled_ = false;
+          flush();
+        },
+        this, 0, 0, windowSeconds_, false, kScheduleKey);
+  }
+}
+
+void FirebaseWriteBatcher::flush() {
+  if (scheduled_) {
+    scheduled_ = false;
+    cocos2d::Director::getInstance()->getScheduler()->unschedule(kScheduleKey,
+                                                                 this);
+  }
+  if (updates_.empty()) return;
+  ++stats_.batches;
+
+  // Take the batch first, so writes made by the callbacks start a new one.
+  Updates updates;
+  updates.swap(updates_);
+  std::shared_ptr<std::vector<Callback>> callbacks =
+      std::make_shared<std::vector<Callback>>();
+  callbacks->swap(callbacks_);
+  writer_(updates, [callbacks](int error, const char* errorMessage) {
+    for (size_t i = 0; i < callbacks->size(); ++i) {
+      (*callbacks)[i](error, errorMessage);
+    }
+  });
+}
+
+FirebaseWriteBatcher::Stats FirebaseWriteBatcher::getStats() const {
+  Stats stats = stats_;
+  stats.pending = updates_.size();
+  return stats;
+}
+
+bool FirebaseWriteBatcher::overlapsBatch(const std::string& path) const {
+  // The root overlaps every other path, so it shares a batch with nothing
+  // but earlier writes of the root itself.
+  if (path.empty() || updates_.count(std::string())) {
+    return !updates_.empty() &&
+           !(updates_.size() == 1 && updates_.begin()->first == path);
+  }
+  // Descendants sort together from `path` + '/'; ancestors are prefixes.
+  Updates::const_iterator next = updates_.lower_bound(path + '/');
+  if (next != updates_.end() && isAncestor(path, next->first)) return true;
+  for (size_t slash = path.find('/'); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    if (updates_.count(path.substr(0, slash))) return true;
+  }
+  return false;
+}
@@ -0,0 +1,100 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FIREBASE_COCOS_CLASSES_FIREBASE_WRITE_BATCHER_H_
+#define FIREBASE_COCOS_CLASSES_FIREBASE_WRITE_BATCHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "firebase/variant.h"
+
+/// Collects database writes made close together and sends them as one
+/// multi-location update, such as DatabaseReference::UpdateChildren, so a
+/// burst of small writes costs one round trip.
+///
+/// A batch is sent once it is `windowSeconds` old or holds `maxBatchSize`
+/// paths, whichever comes first. Writes to a path already in the batch
+/// replace its value. A write to an ancestor or descendant of a path in the
+/// batch sends the batch first, since one update can't contain both. The
+/// empty path is the root of the batch, so it is an ancestor of every other
+/// path and is always sent on its own. Every
+/// write's callback is called with the result of the update that carried it.
+///
+/// All methods must be called on the cocos thread, and the Writer must call
+/// back there too.
+class FirebaseWriteBatcher {
+ public:
+  /// Called with the result of a write: 0 on success, or the error code and
+  /// message of the update.
+  typedef std::function<void(int error, const char* errorMessage)> Callback;
+
+  /// The values of a batch, keyed by path.
+  typedef std::map<std::string, firebase::Variant> Updates;
+
+  /// Sends `updates` in one write and calls `callback` with the result.
+  typedef std::function<void(const Updates& updates, const Callback& callback)>
+      Writer;
+
+  /// The batcher's counters.
+  struct Stats {
+    uint64_t writes;
+    uint64_t coalesced;
+    uint64_t batches;
+    size_t pending;
+  };
+
+  FirebaseWriteBatcher(const Writer& writer, float windowSeconds,
+                       size_t maxBatchSize);
+
+  /// Drops any writes that haven't been sent, without calling back.
+  ~FirebaseWriteBatcher();
+
+  /// Adds a write of `value` to `path` to the current batch.
+  void setValue(const std::string& path, const firebase::Variant& value,
+                const Callback& callback);
+
+  /// Sends the current batch now, if it has any writes.
+  void flush();
+
+  /// Returns the current counters.
+  Stats getStats() const;
+
+ private:
+  /// Returns true if `path` is an ancestor or descendant of a path in the
+  /// current batch, counting the empty path as the ancestor of every path.
+  bool overlapsBatch(const std::string& path) const;
+
+  const Writer writer_;
+  const float windowSeconds_;
+  const size_t maxBatchSize_;
+
+  Updates updates_;
+  std::vector<Callback> callbacks_;
+  bool scheduled_;
+  Stats stats_;
+};
+
+#endif  // FIREBASE_COCOS_CLASSES_FIREBASE_WRITE_BATCHER_H_
@@ -21,6 +21,11 @@
 #include "FirebaseDatabaseScene.h"
 
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include <android/log.h>
@@ -29,6 +34,10 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseLocalBackend.h"
+#include "FirebaseReplay.h"
+#include "FirebaseVariantTable.h"
 #include "firebase/auth.h"
 #include "firebase/database.h"
 #include "firebase/future.h"
@@ -44,10 +53,118 @@ static const char* kValuePlaceholderText = "Value";
 
 static const char* kTestAppData = "test_app_data";
 
-static void logDataSnapshot(FirebaseDatabaseScene* scene,
-                            const firebase::database::DataSnapshot& snapshot) {
-  const firebase::Variant& value_variant = snapshot.value();
-  const char* key = snapshot.key();
+/// Returns the path of `key` in the sample's data. The empty key is the whole
+/// data node.
+static std::string keyPath(const std::string& key) {
+  return key.empty() ? std::string(kTestAppData)
+                     : std::string(kTestAppData) + "/" + key;
+}
+
+/// How long a queried value may be served from the read cache. Values of keys
+/// with a listener are kept up to date by it and don't expire.
+static const double kReadCacheMaxAgeSeconds = 10.0;
+
+/// How long the write batcher waits for more writes before sending a batch,
+/// and the most keys it sends in one UpdateChildren.
+static const float kWriteBatchWindowSeconds = 0.05f;
+static const size_t kWriteBatchMaxSize = 64;
+
+/// The FirebaseReplay channels of the value listener callbacks.
+static const char kValueChangedChannel[] = "database.value";
+static const char kValueCancelledChannel[] = "database.cancelled";
+
+/// The FirebaseReplay channels of the child listener callbacks.
+static const char kChildEventChannel[] = "database.child";
+static const char kChildCancelledChannel[] = "database.child_cancelled";
+
+/// The type names a value is recorded with by FirebaseReplay.
+static const char kNullTypeName[] = "null";
+static const char kInt64TypeName[] = "int64";
+static const char kDoubleTypeName[] = "double";
+static const char kBoolTypeName[] = "bool";
+static const char kStringTypeName[] = "string";
+static const char kUnsupportedTypeName[] = "unsupported";
+
+/// The most children of a map or vector, and the most characters of a string
+/// within one, that are shown when it is logged.
+static const size_t kLoggedChildren = 8;
+static const size_t kLoggedStringLength = 24;
+
+/// Appends a short form of `node` to `text`: scalars as their value, long
+/// strings cut short, and maps and vectors as their number of children.
+static void appendNode(const FirebaseVariantTable::View& node,
+                       std::string* text) {
+  char buffer[64];
+  buffer[0] = '\0';
+  switch (node.type()) {
+    case FirebaseVariantTable::kNodeNull:
+      text->append("null");
+      return;
+    case FirebaseVariantTable::kNodeInt64:
+      snprintf(buffer, sizeof(buffer), "%lld",
+               static_cast<long long>(node.int64Value()));
+      break;
+    case FirebaseVariantTable::kNodeDouble:
+      snprintf(buffer, sizeof(buffer), "%g", node.doubleValue());
+      break;
+    case FirebaseVariantTable::kNodeBool:
+      text->append(node.boolValue() ? "true" : "false");
+      return;
+    case FirebaseVariantTable::kNodeString:
+      text->push_back('"');
+      text->append(node.stringValue(),
+                   std::min(node.size(), kLoggedStringLength));
+      if (node.size() > kLoggedStringLength) text->append("...");
+      text->push_back('"');
+      return;
+    case FirebaseVariantTable::kNodeBlob:
+      snprintf(buffer, sizeof(buffer), "<%i bytes>",
+               static_cast<int>(node.size()));
+      break;
+    case FirebaseVariantTable::kNodeMap:
+      snprintf(buffer, sizeof(buffer), "{%i}",
+               static_cast<int>(node.childCount()));
+      break;
+    case FirebaseVariantTable::kNodeVector:
+      snprintf(buffer, sizeof(buffer), "[%i]",
+               static_cast<int>(node.childCount()));
+      break;
+  }
+  text->append(buffer);
+}
+
+/// Logs a map or vector value as one line: its size and shape, then its first
+/// few children. The value is decoded in a single pass, so a large subtree
+/// costs one walk and one log line rather than a line per node.
+static void logContainer(FirebaseDatabaseScene* scene, const char* key,
+                         const firebase::Variant& value_variant) {
+  // Called from listener threads as well as the cocos thread, so each thread
+  // reuses its own table, and with it the arrays grown by earlier decodes.
+  static thread_local FirebaseVariantTable table;
+  table.decode(value_variant);
+  const FirebaseVariantTable::View root = table.root();
+  std::string children;
+  const size_t shown = std::min(root.childCount(), kLoggedChildren);
+  for (size_t i = 0; i < shown; ++i) {
+    const FirebaseVariantTable::View child = root.child(i);
+    if (i > 0) children.append(", ");
+    if (child.key()) {
+      children.append(child.key());
+      children.append(": ");
+    }
+    appendNode(child, &children);
+  }
+  if (root.childCount() > shown) children.append(", ...");
+  const bool isMap = root.type() == FirebaseVariantTable::kNodeMap;
+  scene->logMessage(
+      "key: \"%s\", value: %s of %i children (%i nodes, depth %i): %s%s%s",
+      key, isMap ? "map" : "vector", static_cast<int>(root.childCount()),
+      static_cast<int>(table.nodeCount()), static_cast<int>(table.maxDepth()),
+      isMap ? "{" : "[", children.c_str(), isMap ? "}" : "]");
+}
+
+static void logValue(FirebaseDatabaseScene* scene, const char* key,
+                     const firebase::Variant& value_variant) {
   switch (value_variant.type()) {
     case firebase::Variant::kTypeNull: {
       scene->logMessage("key: `%s`, value: null", key);
@@ -55,7 +172,8 @@ static void logDataSnapshot(FirebaseDatabaseScene* scene,
     }
     case firebase::Variant::kTypeInt64: {
       int64_t value = value_variant.int64_value();
-      scene->logMessage("key: \"%s\", value: %lli", key, value);
+      scene->logMessage("key: \"%s\", value: %lli", key,
+                        static_cast<long long>(value));
       break;
     }
     case firebase::Variant::kTypeDouble: {
@@ -76,39 +194,156 @@ static void logDataSnapshot(FirebaseDatabaseScene* scene,
                          value ? value : "<null>");
       break;
     }
+    case firebase::Variant::kTypeMap:
+    case firebase::Variant::kTypeVector: {
+      logContainer(scene, key, value_variant);
+      break;
+    }
     default: {
-      scene->logMessage("ERROR: This sample only supports scalar variants.");
+      scene->logMessage("key: \"%s\", value: blob of %i bytes", key,
+                        static_cast<int>(value_variant.blob_size()));
     }
   }
 }
 
-// An example of a ValueListener object. This specific version will
-// simply log every value it sees, and store them in a list so we can
-// confirm that all values were received.
-class SampleValueListener : public firebase::database::ValueListener {
- public:
-  SampleValueListener(FirebaseDatabaseScene* scene) : scene_(scene) {};
+/// Returns the fields FirebaseReplay records a value event with: the key, the
+/// value's type name and the value.
+static FirebaseReplay::Fields valueFields(const char* key,
+                                          const firebase::Variant& value) {
+  FirebaseReplay::Fields fields(1, key ? key : "");
+  switch (value.type()) {
+    case firebase::Variant::kTypeNull:
+      fields.push_back(kNullTypeName);
+      fields.push_back("");
+      break;
+    case firebase::Variant::kTypeInt64:
+      fields.push_back(kInt64TypeName);
+      fields.push_back(FirebaseReplay::formatInt(value.int64_value()));
+      break;
+    case firebase::Variant::kTypeDouble:
+      fields.push_back(kDoubleTypeName);
+      fields.push_back(FirebaseReplay::formatDouble(value.double_value()));
+      break;
+    case firebase::Variant::kTypeBool:
+      fields.push_back(kBoolTypeName);
+      fields.push_back(value.bool_value() ? "1" : "0");
+      break;
+    case firebase::Variant::kTypeMutableString:
+    case firebase::Variant::kTypeStaticString:
+      fields.push_back(kStringTypeName);
+      fields.push_back(value.string_value() ? value.string_value() : "");
+      break;
+    default:
+      fields.push_back(kUnsupportedTypeName);
+      fields.push_back("");
+  }
+  return fields;
+}
 
-  void OnValueChanged(
-      const firebase::database::DataSnapshot& snapshot) override {
-    scene_->logMessage("ValueListener::OnValueChanged");
-    logDataSnapshot(scene_, snapshot);
+/// Rebuilds the value recorded by valueFields(). Unsupported values, such as
+/// maps, vectors and blobs, come back as an empty map.
+static firebase::Variant valueFromFields(const std::string& type,
+                                         const std::string& value) {
+  if (type == kNullTypeName) return firebase::Variant::Null();
+  if (type == kInt64TypeName) {
+    return firebase::Variant::FromInt64(strtoll(value.c_str(), nullptr, 10));
+  }
+  if (type == kDoubleTypeName) {
+    return firebase::Variant::FromDouble(strtod(value.c_str(), nullptr));
   }
+  if (type == kBoolTypeName) return firebase::Variant::FromBool(value == "1");
+  if (type == kStringTypeName) {
+    return firebase::Variant::FromMutableString(value);
+  }
+  return firebase::Variant::EmptyMap();
+}
 
-  void OnCancelled(const firebase::database::Error& error_code,
-                   const char* error_message) override {
-    scene_->logMessage("ERROR: SampleValueListener canceled: %d: %s",
-                       error_code, error_message);
+/// The handling of a listened to key's callbacks, shared with replay.
+static void onValueChanged(FirebaseDatabaseScene* scene, const char* key,
+                           const firebase::Variant& value) {
+  scene->logMessage("ValueListener::OnValueChanged");
+  logValue(scene, key, value);
+}
+
+static void onValueCancelled(FirebaseDatabaseScene* scene, int error_code,
+                             const char* error_message) {
+  FIREBASE_COCOS_LOG_ERROR(scene, "ValueListener canceled: %d: %s",
+                           error_code, error_message);
+}
+
+/// The handling of a child listener's callbacks, shared with replay. Only the
+/// child the event is for is logged.
+static void onChildEvent(FirebaseDatabaseScene* scene, const char* event_name,
+                         const char* previous_key, int child_count,
+                         const char* key, const firebase::Variant& value) {
+  scene->logMessage("ChildListener::%s, %d children%s%s%s", event_name,
+                    child_count, previous_key ? " (after `" : "",
+                    previous_key ? previous_key : "", previous_key ? "`)" : "");
+  logValue(scene, key, value);
+}
+
+static void onChildCancelled(FirebaseDatabaseScene* scene, int error_code,
+                             const char* error_message) {
+  FIREBASE_COCOS_LOG_ERROR(scene, "ChildListener canceled: %d: %s",
+                           error_code, error_message);
+}
+
+/// The logging subscriber of a listened to key. Its callbacks are recorded
+/// for replay.
+static void logValueChanged(FirebaseDatabaseScene* scene, const char* key,
+                            const firebase::Variant& value) {
+  if (FirebaseReplay::isRecording()) {
+    FirebaseReplay::record(kValueChangedChannel, valueFields(key, value));
   }
+  onValueChanged(scene, key, value);
+}
 
- private:
-  FirebaseDatabaseScene* scene_;
-};
+static void logValueCancelled(FirebaseDatabaseScene* scene, int error_code,
+                              const char* error_message) {
+  if (FirebaseReplay::isRecording()) {
+    FirebaseReplay::record(kValueCancelledChannel,
+                           {FirebaseReplay::formatInt(error_code),
+                            error_message ? error_message : ""});
+  }
+  onValueCancelled(scene, error_code, error_message);
+}
 
+/// Logs the callbacks of a child listener, recording them for replay.
+static void logChildEvent(FirebaseDatabaseScene* scene,
+                          FirebaseChildCollection::Event event,
+                          const char* key, const firebase::Variant& value,
+                          const char* previous_key, size_t child_count) {
+  const char* event_name = FirebaseChildCollection::eventName(event);
+  if (FirebaseReplay::isRecording()) {
+    FirebaseReplay::Fields fields;
+    fields.push_back(event_name);
+    fields.push_back(previous_key ? previous_key : "");
+    fields.push_back(
+        FirebaseReplay::formatInt(static_cast<int64_t>(child_count)));
+    const FirebaseReplay::Fields value_fields = valueFields(key, value);
+    fields.insert(fields.end(), value_fields.begin(), value_fields.end());
+    FirebaseReplay::record(kChildEventChannel, fields);
+  }
+  onChildEvent(scene, event_name, previous_key, static_cast<int>(child_count),
+               key, value);
+}
+
+static void logChildCancelled(FirebaseDatabaseScene* scene, int error_code,
+                              const char* error_message) {
+  if (FirebaseReplay::isRecording()) {
+    FirebaseReplay::record(kChildCancelledChannel,
+                           {FirebaseReplay::formatInt(error_code),
+                            error_message ? error_message : ""});
+  }
+  onChildCancelled(scene, error_code, error_message);
+}
+
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseDatabaseScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseDatabaseScene.
 Scene* FirebaseDatabaseScene::createScene() {
@@ -124,6 +359,15 @@ Scene* FirebaseDatabaseScene::createScene() {
   return scene;
 }
 
+FirebaseDatabaseScene::FirebaseDatabaseScene()
+    : read_cache_(kReadCacheMaxAgeSeconds),
+      write_batcher_(
+          [this](const FirebaseWriteBatcher::Updates& updates,
+                 const FirebaseWriteBatcher::Callback& callback) {
+            writeBatch(updates, callback);
+          },
+          kWriteBatchWindowSeconds, kWriteBatchMaxSize) {}
+
 /// Initializes the FirebaseScene.
 bool FirebaseDatabaseScene::init() {
   if (!Layer::init()) {
@@ -151,6 +395,13 @@ bool FirebaseDatabaseScene::init() {
       ->performFunctionInCocosThread(
           [=]() { this->createScrollView(scrollViewYPosition); });
 
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+  // The local backend stands in for Auth and Database.
+  auth_ = nullptr;
+  database_ = nullptr;
+  initializeAndSignIn();
+  logMessage("Using the local backend instead of Firebase Database.");
+#else
   // Use ModuleInitializer to initialize both Auth and Database, ensuring no
   // dependencies are missing.
   void* initialize_targets[] = {&auth_, &database_};
@@ -177,15 +428,17 @@ bool FirebaseDatabaseScene::init() {
   // There are two ways to track long running operations: (1) retrieve the
   // future using a LastResult function or (2) Cache the future manually.
   //
-  // Here we use method 1: the future is not cached but will be later retrieved
-  // using SetValueLastResult. Which method is best for your app depends on
-  // your use case.
+  // Here we use method 1: the future is not cached but is retrieved using
+  // InitializeLastResult in initializeAndSignIn. Which method is best for your
+  // app depends on your use case.
   initializer_.Initialize(
       firebase::App::GetInstance(), initialize_targets, initializers,
       sizeof(initializers) / sizeof(initializers[0]));
+  initializeAndSignIn();
 
   logMessage("Created the Database %x class for the Firebase app.",
              static_cast<int>(reinterpret_cast<intptr_t>(database_)));
+#endif  // defined(FIREBASE_COCOS_LOCAL_BACKEND)
 
   key_text_field_ = createTextField(kKeyPlaceholderText);
   this->addChild(key_text_field_);
@@ -196,16 +449,12 @@ bool FirebaseDatabaseScene::init() {
   add_listener_button_ = createButton(false, "Add Listener");
   add_listener_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Database add listener button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
-            const char* key = key_text_field_->getString().c_str();
-            firebase::database::DatabaseReference reference =
-                this->database_->GetReference(kTestAppData).Child(key);
-            this->logMessage("Adding ValueListener to key `%s`.", key);
-            // The SampleValueListener will respond to changes in this entry's
-            // value. Changes can be made by other instances of this sample app
-            // or in the Firebase Console.
-            reference.AddValueListener(new SampleValueListener(this));
+            const std::string& key = key_text_field_->getString();
+            this->logMessage("Adding ValueListener to key `%s`.", key.c_str());
+            this->addListener(key);
             break;
           }
           default: {
@@ -215,25 +464,37 @@ bool FirebaseDatabaseScene::init() {
       });
   this->addChild(add_listener_button_);
 
+  child_listener_button_ = createButton(false, "Listen Children");
+  child_listener_button_->addTouchEventListener(
+      [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Database listen children button");
+        switch (type) {
+          case cocos2d::ui::Widget::TouchEventType::ENDED: {
+            const std::string& key = key_text_field_->getString();
+            this->logMessage("Adding ChildListener to key `%s`.", key.c_str());
+            this->addChildListener(key);
+            break;
+          }
+          default: {
+            break;
+          }
+        }
+      });
+  this->addChild(child_listener_button_);
+
   query_button_ = createButton(false, "Query");
   query_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Database query button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
-            const char* key = key_text_field_->getString().c_str();
-            firebase::database::DatabaseReference reference =
-                this->database_->GetReference(kTestAppData).Child(key);
-            this->logMessage("Querying key `%s`.", key);
-            // There are two ways to track long running operations:
-            // (1) retrieve the future using a LastResult function or (2) Cache
-            // the future manually.
-            //
-            // Here (and below in the set_button_) we use method 2: caching the
-            // future. Which method is best for your app depends on your use
-            // case.
-            query_future_ = reference.GetValue();
-            this->query_button_->setEnabled(false);
-            this->set_button_->setEnabled(false);
+            const std::string key = key_text_field_->getString();
+            this->logMessage("Queueing %d queries of key `%s`.",
+                             pipeline_.getBurstSize(), key.c_str());
+            pipeline_.pushBurst(
+                [this, key](const FirebaseRequestPipeline::Done& done) {
+                  this->startQuery(key, done);
+                });
             break;
           }
           default: {
@@ -246,16 +507,18 @@ bool FirebaseDatabaseScene::init() {
   set_button_ = createButton(false, "Set");
   set_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Database set button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
-            const char* key = key_text_field_->getString().c_str();
-            const char* value = value_text_field_->getString().c_str();
-            firebase::database::DatabaseReference reference =
-                this->database_->GetReference(kTestAppData).Child(key);
-            this->logMessage("Setting key `%s` to `%s`.", key, value);
-            this->set_future_ = reference.SetValue(value);
-            this->query_button_->setEnabled(false);
-            this->set_button_->setEnabled(false);
+            const std::string key = key_text_field_->getString();
+            const std::string value = value_text_field_->getString();
+            this->logMessage("Queueing %d writes of `%s` to key `%s`.",
+                             pipeline_.getBurstSize(), value.c_str(),
+                             key.c_str());
+            pipeline_.pushBurst(
+                [this, key, value](const FirebaseRequestPipeline::Done& done) {
+                  this->startSet(key, value, done);
+                });
             break;
           }
           default: {
@@ -265,6 +528,8 @@ bool FirebaseDatabaseScene::init() {
       });
   this->addChild(set_button_);
 
+  createRequestPipelineControls(&pipeline_);
+
   // Create the close app menu item.
   auto closeAppItem = MenuItemImage::create(
       "CloseNormal.png", "CloseSelected.png",
@@ -281,103 +546,350 @@ bool FirebaseDatabaseScene::init() {
   menu->setPosition(cocos2d::Vec2::ZERO);
   this->addChild(menu, 1);
 
-  state_ = kStateInitialize;
-
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
+  // Replayed listener callbacks run the same code as the logging subscriber.
+  FirebaseReplay::setHandler(
+      kValueChangedChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 3) return;
+        onValueChanged(this, fields[0].c_str(),
+                       valueFromFields(fields[1], fields[2]));
+      });
+  FirebaseReplay::setHandler(
+      kValueCancelledChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 2) return;
+        onValueCancelled(this, atoi(fields[0].c_str()), fields[1].c_str());
+      });
+  FirebaseReplay::setHandler(
+      kChildEventChannel, this, [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 6) return;
+        onChildEvent(this, fields[0].c_str(),
+                     fields[1].empty() ? nullptr : fields[1].c_str(),
+                     atoi(fields[2].c_str()), fields[3].c_str(),
+                     valueFromFields(fields[4], fields[5]));
+      });
+  FirebaseReplay::setHandler(
+      kChildCancelledChannel, this,
+      [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 2) return;
+        onChildCancelled(this, atoi(fields[0].c_str()), fields[1].c_str());
+      });
 
   return true;
 }
 
-FirebaseDatabaseScene::State FirebaseDatabaseScene::updateInitialize() {
-  firebase::Future<void> initialize_future =
-      initializer_.InitializeLastResult();
-  if (initialize_future.status() != firebase::kFutureStatusComplete) {
-    return kStateInitialize;
-  }
-  if (initialize_future.error() != 0) {
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+void FirebaseDatabaseScene::initializeAndSignIn() {
+  FirebaseLocalBackend::signInAnonymously(
+      this,
+      [this](const FirebaseLocalBackend::Result& result) {
+        onSignInResult(result.error, result.errorMessage.c_str());
+      },
+      FirebaseTrace::begin("Auth SignInAnonymously"));
+}
+#else
+void FirebaseDatabaseScene::initializeAndSignIn() {
+  FirebaseCompletionDispatcher::onCompletion(
+      initializer_.InitializeLastResult(), this,
+      [this](const firebase::Future<void>& future) {
+        if (!onInitializeComplete(future)) return;
+        // Sign in using Auth before accessing the database.
+        //
+        // The default Database permissions allow anonymous user access.
+        // However, Firebase Auth does not allow anonymous user login by
+        // default. This setting can be changed in the Auth settings page for
+        // your project in the Firebase Console under the "Sign-In Method" tab.
+        FirebaseCompletionDispatcher::onCompletion(
+            auth_->SignInAnonymously(), this,
+            CC_CALLBACK_1(FirebaseDatabaseScene::onSignInComplete, this),
+            FirebaseTrace::begin("Auth SignInAnonymously"));
+      },
+      FirebaseTrace::begin("Database ModuleInitializer"));
+}
+#endif
+
+bool FirebaseDatabaseScene::onInitializeComplete(
+    const firebase::Future<void>& future) {
+  if (future.error() != 0) {
     logMessage("Failed to initialize Firebase libraries: %s",
-               initialize_future.error_message());
-    return kStateRun;
+               future.error_message());
+    return false;
   }
   logMessage("Successfully initialized Firebase Auth and Firebase Database.");
-  auth_->SignInAnonymously();
-  return kStateLogin;
+  return true;
 }
 
-FirebaseDatabaseScene::State FirebaseDatabaseScene::updateLogin() {
-  // Sign in using Auth before accessing the database.
-  //
-  // The default Database permissions allow anonymous user access. However,
-  // Firebase Auth does not allow anonymous user login by default. This setting
-  // can be changed in the Auth settings page for your project in the Firebase
-  // Console under the "Sign-In Method" tab.
-  firebase::Future<firebase::auth::User*> sign_in_future =
-      auth_->SignInAnonymouslyLastResult();
-  if (sign_in_future.status() != firebase::kFutureStatusComplete) {
-    return kStateLogin;
-  }
-  if (sign_in_future.error() != firebase::auth::kAuthErrorNone) {
-    logMessage("ERROR: Could not sign in anonymously. Error %d: %s",
-               sign_in_future.error(), sign_in_future.error_message());
+void FirebaseDatabaseScene::onSignInComplete(
+    const firebase::Future<firebase::auth::User*>& future) {
+  onSignInResult(future.error(), future.error_message());
+}
+
+void FirebaseDatabaseScene::onSignInResult(int error,
+                                           const char* error_message) {
+  if (error != firebase::auth::kAuthErrorNone) {
+    FIREBASE_COCOS_LOG_ERROR(this,
+                             "Could not sign in anonymously. Error %d: %s",
+                             error, error_message);
     logMessage(
         "Ensure your application has the Anonymous sign-in provider enabled in "
         "the Firebase Console.");
-    return kStateRun;
+    return;
   }
   logMessage("Auth: Signed in anonymously.");
   add_listener_button_->setEnabled(true);
+  child_listener_button_->setEnabled(true);
   query_button_->setEnabled(true);
   set_button_->setEnabled(true);
-  return kStateRun;
-}
-
-FirebaseDatabaseScene::State FirebaseDatabaseScene::updateRun() {
-  if (query_future_.status() == firebase::kFutureStatusComplete) {
-    if (query_future_.error() == firebase::database::kErrorNone) {
-      logMessage("Query complete");
-      const firebase::database::DataSnapshot* snapshot = query_future_.result();
-      logDataSnapshot(this, *snapshot);
-    } else {
-      logMessage("ERROR: Could not query value. Error %d: %s",
-                 query_future_.error(), query_future_.error_message());
-    }
-    query_button_->setEnabled(true);
-    set_button_->setEnabled(true);
-    query_future_.Release();
+}
+
+void FirebaseDatabaseScene::onQueryComplete(
+    const firebase::Future<firebase::database::DataSnapshot>& future) {
+  const firebase::database::DataSnapshot* snapshot = future.result();
+  if (future.error() == firebase::database::kErrorNone && snapshot) {
+    onQueryResult(future.error(), future.error_message(), snapshot->key(),
+                  snapshot->value());
+  } else {
+    onQueryResult(future.error(), future.error_message(), nullptr,
+                  firebase::Variant::Null());
   }
-  if (set_future_.status() == firebase::kFutureStatusComplete) {
-    if (set_future_.error() == firebase::database::kErrorNone) {
-      logMessage("Database updated.");
-    } else {
-      logMessage("ERROR: Could not set value. Error %d: %s",
-                 set_future_.error(), set_future_.error_message());
-    }
-    query_button_->setEnabled(true);
-    set_button_->setEnabled(true);
-    set_future_.Release();
+}
+
+void FirebaseDatabaseScene::onQueryResult(int error, const char* error_message,
+                                          const char* key,
+                                          const firebase::Variant& value) {
+  if (error == firebase::database::kErrorNone) {
+    logMessage("Query complete");
+    logValue(this, key, value);
+  } else {
+    FIREBASE_COCOS_LOG_ERROR(this, "Could not query value. Error %d: %s",
+                             error, error_message);
+  }
+}
+
+void FirebaseDatabaseScene::onSetResult(int error, const char* error_message) {
+  if (error == firebase::database::kErrorNone) {
+    logMessage("Database updated.");
+  } else {
+    FIREBASE_COCOS_LOG_ERROR(this, "Could not set value. Error %d: %s",
+                             error, error_message);
+  }
+}
+
+void FirebaseDatabaseScene::addListener(const std::string& key) {
+  if (!listened_keys_.insert(key).second) {
+    logMessage("Already listening to key `%s`.", key.c_str());
+    return;
+  }
+  const std::string path = keyPath(key);
+  // The read cache and the log each subscribe to the key, and share one
+  // listener on it. Changes can be made by other instances of this sample app
+  // or in the Firebase Console. With the local backend database_ is null, so
+  // the listener is added there.
+  subscriptions_.subscribe(
+      database_, path,
+      [this, path](const char* /*value_key*/, const firebase::Variant& value) {
+        read_cache_.mirror(path, value);
+      },
+      [this, path](int /*error*/, const char* /*error_message*/) {
+        read_cache_.invalidate(path);
+      });
+  subscriptions_.subscribe(
+      database_, path,
+      [this](const char* value_key, const firebase::Variant& value) {
+        logValueChanged(this, value_key, value);
+      },
+      [this](int error, const char* error_message) {
+        logValueCancelled(this, error, error_message);
+      });
+}
+
+void FirebaseDatabaseScene::addChildListener(const std::string& key) {
+  std::unique_ptr<FirebaseChildSubscription>& subscription =
+      child_subscriptions_[key];
+  if (subscription) {
+    logMessage("Already listening to the children of key `%s`.", key.c_str());
+    return;
   }
-  return kStateRun;
+  const std::string path = keyPath(key);
+  // Each event carries only the child it is for, so a large node costs one
+  // child's worth per update. The children are mirrored into the read cache,
+  // so queries of them are served locally too.
+  subscription.reset(new FirebaseChildSubscription);
+  subscription->start(
+      database_, path,
+      [this, path](FirebaseChildCollection::Event event, const char* child_key,
+                   const firebase::Variant& value, const char* previous_key,
+                   size_t child_count) {
+        const std::string child_path = path + "/" + child_key;
+        if (event == FirebaseChildCollection::kChildRemoved) {
+          read_cache_.mirror(child_path, firebase::Variant::Null());
+        } else if (event != FirebaseChildCollection::kChildMoved) {
+          read_cache_.mirror(child_path, value);
+        }
+        logChildEvent(this, event, child_key, value, previous_key,
+                      child_count);
+      },
+      [this, path](int error, const char* error_message) {
+        read_cache_.invalidate(path);
+        logChildCancelled(this, error, error_message);
+      });
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
-void FirebaseDatabaseScene::update(float /*delta*/) {
-  switch (state_) {
-    case kStateInitialize: state_ = updateInitialize(); break;
-    case kStateLogin: state_ = updateLogin(); break;
-    case kStateRun: state_ = updateRun(); break;
-    default: assert(0);
+void FirebaseDatabaseScene::startQuery(
+    const std::string& key, const FirebaseRequestPipeline::Done& done) {
+  const std::string path = keyPath(key);
+  firebase::Variant cached;
+  if (read_cache_.lookup(path, &cached)) {
+    FIREBASE_COCOS_LOG_DEBUG(this, "Query of `%s` served from the read cache.",
+                             key.c_str());
+    onQueryResult(firebase::database::kErrorNone, "", key.c_str(), cached);
+    done(true);
+    return;
   }
+  // A write started while the query is in flight stops its result from being
+  // cached.
+  const uint64_t generation = read_cache_.generation();
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+  FirebaseLocalBackend::getValue(
+      path, this,
+      [this, key, path, generation,
+       done](const FirebaseLocalBackend::Result& result) {
+        if (result.error == firebase::database::kErrorNone) {
+          read_cache_.fill(path, result.value, generation);
+        }
+        onQueryResult(result.error, result.errorMessage.c_str(), key.c_str(),
+                      result.value);
+        done(result.error == firebase::database::kErrorNone);
+      },
+      FirebaseTrace::begin("Database GetValue"));
+#else
+  // Rather than polling the future every frame, ask to be called back on the
+  // cocos thread once it completes.
+  firebase::database::DatabaseReference reference =
+      database_->GetReference(kTestAppData).Child(key.c_str());
+  FirebaseCompletionDispatcher::onCompletion(
+      reference.GetValue(), this,
+      [this, path, generation, done](
+          const firebase::Future<firebase::database::DataSnapshot>& future) {
+        const firebase::database::DataSnapshot* snapshot = future.result();
+        if (future.error() == firebase::database::kErrorNone && snapshot) {
+          read_cache_.fill(path, snapshot->value(), generation);
+        }
+        onQueryComplete(future);
+        done(future.error() == firebase::database::kErrorNone);
+      },
+      FirebaseTrace::begin("Database GetValue"));
+#endif  // defined(FIREBASE_COCOS_LOCAL_BACKEND)
+}
+
+void FirebaseDatabaseScene::startSet(
+    const std::string& key, const std::string& value,
+    const FirebaseRequestPipeline::Done& done) {
+  const std::string path = keyPath(key);
+  // Invalidate when the write starts, so later queries don't see the old
+  // value, and again when it finishes, so queries that raced it aren't kept.
+  read_cache_.invalidate(path);
+  const FirebaseWriteBatcher::Callback callback =
+      [this, path, done](int error, const char* error_message) {
+        read_cache_.invalidate(path);
+        onSetResult(error, error_message);
+        done(error == firebase::database::kErrorNone);
+      };
+  if (key.empty()) {
+    // The empty key replaces the whole data node, which overlaps every key,
+    // so the batch so far is sent first and the node gets a SetValue of its
+    // own.
+    write_batcher_.flush();
+    writeRoot(firebase::Variant::FromMutableString(value), callback);
+    return;
+  }
+  // Rather than a SetValue of its own, the write joins the current batch,
+  // which is sent as one UpdateChildren.
+  write_batcher_.setValue(key, firebase::Variant::FromMutableString(value),
+                          callback);
+}
+
+void FirebaseDatabaseScene::writeRoot(
+    const firebase::Variant& value,
+    const FirebaseWriteBatcher::Callback& callback) {
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+  FirebaseLocalBackend::setValue(
+      kTestAppData, value, this,
+      [callback](const FirebaseLocalBackend::Result& result) {
+        callback(result.error, result.errorMessage.c_str());
+      },
+      FirebaseTrace::begin("Database SetValue"));
+#else
+  FirebaseCompletionDispatcher::onCompletion(
+      database_->GetReference(kTestAppData).SetValue(value), this,
+      [callback](const firebase::Future<void>& future) {
+        callback(future.error(), future.error_message());
+      },
+      FirebaseTrace::begin("Database SetValue"));
+#endif  // defined(FIREBASE_COCOS_LOCAL_BACKEND)
+}
+
+void FirebaseDatabaseScene::writeBatch(
+    const FirebaseWriteBatcher::Updates& updates,
+    const FirebaseWriteBatcher::Callback& callback) {
+  FIREBASE_COCOS_LOG_DEBUG(this, "Writing %d keys in one update.",
+                           static_cast<int>(updates.size()));
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+  FirebaseLocalBackend::updateChildren(
+      kTestAppData, updates, this,
+      [callback](const FirebaseLocalBackend::Result& result) {
+        callback(result.error, result.errorMessage.c_str());
+      },
+      FirebaseTrace::begin("Database UpdateChildren"));
+#else
+  FirebaseCompletionDispatcher::onCompletion(
+      database_->GetReference(kTestAppData).UpdateChildren(updates), this,
+      [callback](const firebase::Future<void>& future) {
+        callback(future.error(), future.error_message());
+      },
+      FirebaseTrace::begin("Database UpdateChildren"));
+#endif  // defined(FIREBASE_COCOS_LOCAL_BACKEND)
+}
+
+// Futures are handled by completion callbacks, so there is nothing to poll and
+// the update is not scheduled.
+void FirebaseDatabaseScene::update(float /*delta*/) {}
+
+void FirebaseDatabaseScene::removeListeners() {
+  subscriptions_.unsubscribeAll();
+  listened_keys_.clear();
+  child_subscriptions_.clear();
+  // Nothing keeps the mirrored values up to date any more.
+  read_cache_.clear();
 }
 
 /// Handles the user tapping on the close app menu item.
 void FirebaseDatabaseScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Database C++ resources.");
-
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  pipeline_.clear();
+  // Send the writes still waiting for their batch window.
+  write_batcher_.flush();
+  for (const auto& entry : child_subscriptions_) {
+    const FirebaseChildCollection::Stats events = entry.second->getStats();
+    logMessage(
+        "Children of key `%s`: %d kept from %llu added, %llu changed, "
+        "%llu moved and %llu removed.",
+        entry.first.c_str(), static_cast<int>(entry.second->getChildCount()),
+        static_cast<unsigned long long>(events.added),
+        static_cast<unsigned long long>(events.changed),
+        static_cast<unsigned long long>(events.moved),
+        static_cast<unsigned long long>(events.removed));
+  }
+  removeListeners();
+  const FirebaseReadCache::Stats stats = read_cache_.getStats();
+  logMessage("Read cache: %llu hits, %llu misses.",
+             static_cast<unsigned long long>(stats.hits),
+             static_cast<unsigned long long>(stats.misses));
+  const FirebaseWriteBatcher::Stats batches = write_batcher_.getStats();
+  logMessage("Write batcher: %llu writes in %llu updates, %llu coalesced.",
+             static_cast<unsigned long long>(batches.writes),
+             static_cast<unsigned long long>(batches.batches),
+             static_cast<unsigned long long>(batches.coalesced));
+
+  closeSample();
 }
@@ -21,11 +21,21 @@
 #ifndef FIREBASE_COCOS_CLASSES_FIREBASE_DATABASE_SCENE_H_
 #define FIREBASE_COCOS_CLASSES_FIREBASE_DATABASE_SCENE_H_
 
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
 #include "cocos2d.h"
 #include "ui/CocosGUI.h"
 
+#include "FirebaseChildSubscription.h"
 #include "FirebaseCocos.h"
+#include "FirebaseReadCache.h"
+#include "FirebaseRequestPipeline.h"
+#include "FirebaseWriteBatcher.h"
 #include "FirebaseScene.h"
+#include "FirebaseValueSubscriptions.h"
 #include "firebase/auth.h"
 #include "firebase/database.h"
 #include "firebase/future.h"
@@ -35,6 +45,8 @@ class FirebaseDatabaseScene : public FirebaseScene {
  public:
   static cocos2d::Scene *createScene();
 
+  FirebaseDatabaseScene();
+
   bool init() override;
 
   void update(float delta) override;
@@ -44,26 +56,56 @@ class FirebaseDatabaseScene : public FirebaseScene {
   CREATE_FUNC(FirebaseDatabaseScene);
 
  private:
-  /// An enum that tracks what the operations the app should be keeping track
-  /// of. First the app initializes the library, then it logs in using Firebase
+  /// First the app initializes the library, then it logs in using Firebase
   /// Authentication, and then it listens for reads or writes to the database.
-  enum State {
-    kStateInitialize,
-    kStateLogin,
-    kStateRun,
-  };
-
-  /// The update loop to run while initializing the app.
-  State updateInitialize();
-
-  /// The update loop to run while logging in.
-  State updateLogin();
-
-  /// The update loop to run once all setup is complete.
-  State updateRun();
-
-  /// Tracks the current state of the app through its setup and main loop.
-  State state_;
+  /// This runs the first two steps, each once the previous step's Future
+  /// completes.
+  void initializeAndSignIn();
+
+  /// Called when Auth and Database have been initialized. Returns true if
+  /// initialization succeeded.
+  bool onInitializeComplete(const firebase::Future<void>& future);
+
+  /// Called when the anonymous sign in completes.
+  void onSignInComplete(const firebase::Future<firebase::auth::User*>& future);
+  void onSignInResult(int error, const char* error_message);
+
+  /// Called when a query started by the query button completes. `key` and
+  /// `value` are those of the snapshot read.
+  void onQueryComplete(
+      const firebase::Future<firebase::database::DataSnapshot>& future);
+  void onQueryResult(int error, const char* error_message, const char* key,
+                     const firebase::Variant& value);
+
+  /// Called when a write started by the set button completes.
+  void onSetResult(int error, const char* error_message);
+
+  /// Start the operations of the add listener, listen children, query and set
+  /// buttons, on Firebase or, with FIREBASE_COCOS_LOCAL_BACKEND, on the local
+  /// backend.
+  /// Queries and writes are requests of `pipeline_`, and call `done` once
+  /// their result has been handled. A query of a value in `read_cache_` is
+  /// handled before startQuery returns.
+  void addListener(const std::string& key);
+  void addChildListener(const std::string& key);
+  void startQuery(const std::string& key,
+                  const FirebaseRequestPipeline::Done& done);
+  void startSet(const std::string& key, const std::string& value,
+                const FirebaseRequestPipeline::Done& done);
+
+  /// Sends a batch of writes collected by `write_batcher_` as one
+  /// UpdateChildren of kTestAppData.
+  void writeBatch(const FirebaseWriteBatcher::Updates& updates,
+                  const FirebaseWriteBatcher::Callback& callback);
+
+  /// Replaces the whole kTestAppData node with `value` in one SetValue,
+  /// outside of any batch.
+  void writeRoot(const firebase::Variant& value,
+                 const FirebaseWriteBatcher::Callback& callback);
+
+  /// Ends the subscriptions added by the add listener and listen children
+  /// buttons.
+  void removeListeners();
 
   /// The ModuleInitializer is a utility class to make initializing multiple
   /// Firebase libraries easier.
@@ -75,12 +117,6 @@ class FirebaseDatabaseScene : public FirebaseScene {
   /// Firebase Realtime Database, the entry point to all database operations.
   firebase::database::Database* database_;
 
-  /// A future that completes when the DataSnapshot for a query is received.
-  firebase::Future<firebase::database::DataSnapshot> query_future_;
-
-  /// A future that completes when a databse write is complete.
-  firebase::Future<void> set_future_;
-
   /// A text field where a database key string may be entered.
   cocos2d::ui::TextField* key_text_field_;
 
@@ -90,11 +126,38 @@ class FirebaseDatabaseScene : public FirebaseScene {
   /// A button that sets a listener on the node given by the key text field.
   cocos2d::ui::Button* add_listener_button_;
 
+  /// A button that listens to the children of the node given by the key text
+  /// field, or of the sample's data if it is empty.
+  cocos2d::ui::Button* child_listener_button_;
+
   /// A button that queries the value given by the key text field.
   cocos2d::ui::Button* query_button_;
 
   /// A button that sets the key to the value, given by the text fields.
   cocos2d::ui::Button* set_button_;
+
+  /// Runs the queries and writes queued by the query and set buttons.
+  FirebaseRequestPipeline pipeline_;
+
+  /// The values of recent queries and of the keys being listened to.
+  FirebaseReadCache read_cache_;
+
+  /// Merges the writes of the set button that are in flight together.
+  FirebaseWriteBatcher write_batcher_;
+
+  /// The subscriptions of the keys added by the add listener button, which
+  /// share one listener per key. Declared after read_cache_, which they
+  /// update, so they are removed first.
+  FirebaseValueSubscriptions subscriptions_;
+
+  /// The keys added by the add listener button.
+  std::set<std::string> listened_keys_;
+
+  /// The children of the keys added by the listen children button, each kept
+  /// up to date one child event at a time. Declared after read_cache_, which
+  /// they update, so they are removed first.
+  std::map<std::string, std::unique_ptr<FirebaseChildSubscription>>
+      child_subscriptions_;
 };
 
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_DATABASE_SCENE_H_
@@ -0,0 +1,174 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FirebaseHostScene.h"
+
+#include "FirebaseAdMobScene.h"
+#include "FirebaseAnalyticsScene.h"
+#include "FirebaseAuthScene.h"
+#include "FirebaseCocos.h"
+#include "FirebaseDatabaseScene.h"
+#include "FirebaseInvitesScene.h"
+#include "FirebaseMessagingScene.h"
+#include "FirebaseRemoteConfigScene.h"
+#include "FirebaseStorageScene.h"
+
+USING_NS_CC;
+
+/// Padding for the UI elements.
+static const float kUIElementPadding = 10.0;
+
+/// A sample the host app can open.
+struct HostSample {
+  /// The title of the sample's button.
+  const char* title;
+  /// Creates the sample's scene.
+  cocos2d::Scene* (*createScene)();
+};
+
+/// The samples, in the order of their buttons.
+static const HostSample kHostSamples[] = {
+    {"AdMob", FirebaseAdMobScene::createScene},
+    {"Analytics", FirebaseAnalyticsScene::createScene},
+    {"Auth", FirebaseAuthScene::createScene},
+    {"Database", FirebaseDatabaseScene::createScene},
+    {"Invites", FirebaseInvitesScene::createScene},
+    {"Messaging", FirebaseMessagingScene::createScene},
+    {"Remote Config", FirebaseRemoteConfigScene::createScene},
+    {"Storage", FirebaseStorageScene::createScene},
+};
+static const size_t kHostSampleCount =
+    sizeof(kHostSamples) / sizeof(kHostSamples[0]);
+
+/// The title text for the button that opens every sample.
+static const char* kOpenAllButtonText = "Open All";
+
+/// Creates the Firebase scene.
+Scene* CreateFirebaseScene() {
+  return FirebaseHostScene::createScene();
+}
+
+/// Creates the FirebaseHostScene.
+Scene* FirebaseHostScene::createScene() {
+  // Create the scene.
+  auto scene = Scene::create();
+
+  // Create the layer.
+  auto layer = FirebaseHostScene::create();
+
+  // Add the layer to the scene.
+  scene->addChild(layer);
+
+  return scene;
+}
+
+/// Initializes the FirebaseScene.
+bool FirebaseHostScene::init() {
+  if (!Layer::init()) {
+    return false;
+  }
+
+  auto visibleSize = Director::getInstance()->getVisibleSize();
+  cocos2d::Vec2 origin = Director::getInstance()->getVisibleOrigin();
+
+  // Create the Firebase label.
+  auto firebaseLabel =
+      Label::createWithTTF("Firebase", "fonts/Marker Felt.ttf", 20);
+  nextYPosition =
+      origin.y + visibleSize.height - firebaseLabel->getContentSize().height;
+  firebaseLabel->setPosition(
+      cocos2d::Vec2(origin.x + visibleSize.width / 2, nextYPosition));
+  this->addChild(firebaseLabel, 1);
+
+  // Lay the sample buttons out in two columns. createButton places buttons in
+  // the left column, so the second half are moved to the right.
+  const float columnTop = nextYPosition - kUIElementPadding;
+  const size_t rows = (kHostSampleCount + 1) / 2;
+  float columnBottom = columnTop;
+  for (size_t i = 0; i < kHostSampleCount; ++i) {
+    if (i == rows) {
+      columnBottom = nextYPosition;
+      nextYPosition = columnTop;
+    }
+    const HostSample& sample = kHostSamples[i];
+    cocos2d::ui::Button* button = createButton(true, sample.title);
+    if (i >= rows) {
+      button->setPositionX(origin.x + visibleSize.width * 3 / 4);
+    }
+    button->addTouchEventListener(
+        [&sample](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+          if (type == cocos2d::ui::Widget::TouchEventType::ENDED) {
+            CCLOG("Opening the %s sample.", sample.title);
+            Director::getInstance()->pushScene(sample.createScene());
+          }
+        });
+    this->addChild(button);
+  }
+
+  // Opening every sample initializes all of their modules at once, so the
+  // combined footprint of the modules can be measured. Closing a sample then
+  // reveals the one opened before it.
+  nextYPosition = columnBottom;
+  cocos2d::ui::Button* openAllButton = createButton(true, kOpenAllButtonText);
+  openAllButton->setPositionX(origin.x + visibleSize.width / 2);
+  openAllButton->addTouchEventListener(
+      [](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        if (type == cocos2d::ui::Widget::TouchEventType::ENDED) {
+          CCLOG("Opening every sample.");
+          for (size_t i = 0; i < kHostSampleCount; ++i) {
+            Director::getInstance()->pushScene(kHostSamples[i].createScene());
+          }
+        }
+      });
+  this->addChild(openAllButton);
+
+  // Create the close app menu item.
+  auto closeAppItem = MenuItemImage::create(
+      "CloseNormal.png", "CloseSelected.png",
+      CC_CALLBACK_1(FirebaseScene::menuCloseAppCallback, this));
+  closeAppItem->setContentSize(cocos2d::Size(25, 25));
+  // Position the close app menu item on the top-right corner of the screen.
+  closeAppItem->setPosition(cocos2d::Vec2(
+      origin.x + visibleSize.width - closeAppItem->getContentSize().width / 2,
+      origin.y + visibleSize.height -
+          closeAppItem->getContentSize().height / 2));
+
+  // Create the Menu for touch handling.
+  auto menu = Menu::create(closeAppItem, NULL);
+  menu->setPosition(cocos2d::Vec2::ZERO);
+  this->addChild(menu, 1);
+
+  return true;
+}
+
+// There is nothing to do each frame, so the update is not scheduled.
+void FirebaseHostScene::update(float /*delta*/) {}
+
+/// Handles the user tapping on the close app menu item.
+void FirebaseHostScene::menuCloseAppCallback(Ref* pSender) {
+  CCLOG("Closing the host app.");
+
+  // Close the cocos2d-x game scene and quit the application.
+  Director::getInstance()->end();
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+  exit(0);
+#endif
+}
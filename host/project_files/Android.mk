@@ -0,0 +1,134 @@
+LOCAL_PATH := $(call my-dir)
+
+APP_ABI := armeabi-v7a x86 arm64
+
+STL := $(firstword $(subst _, ,$(APP_STL)))
+FIREBASE_CPP_SDK_DIR := ../../../Libs/firebase_cpp_sdk
+FIREBASE_LIBRARY_PATH := $(FIREBASE_CPP_SDK_DIR)/libs/android/$(TARGET_ARCH_ABI)/$(STL)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_app
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libapp.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_admob
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libadmob.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_analytics
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libanalytics.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_auth
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libauth.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_database
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libdatabase.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_invites
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libinvites.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_messaging
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libmessaging.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_remote_config
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libremote_config.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := firebase_storage
+LOCAL_SRC_FILES := $(FIREBASE_LIBRARY_PATH)/libstorage.a
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(FIREBASE_CPP_SDK_DIR)/include
+include $(PREBUILT_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+
+$(call import-add-path,$(LOCAL_PATH)/../../../cocos2d)
+$(call import-add-path,$(LOCAL_PATH)/../../../cocos2d/external)
+$(call import-add-path,$(LOCAL_PATH)/../../../cocos2d/cocos)
+$(call import-add-path,$(LOCAL_PATH)/../../../cocos2d/cocos/audio/include)
+
+LOCAL_MODULE := MyGame_shared
+
+LOCAL_MODULE_FILENAME := libMyGame
+
+LOCAL_SRC_FILES := hellocpp/main.cpp \
+                   ../../../Classes/AppDelegate.cpp \
+                   ../../../Classes/FirebaseScene.cpp \
+                   ../../../Classes/FirebaseChildSubscription.cpp \
+                   ../../../Classes/FirebaseChildCollection.cpp \
+                   ../../../Classes/FirebaseVariantTable.cpp \
+                   ../../../Classes/FirebaseValueSubscriptions.cpp \
+                   ../../../Classes/FirebaseWriteBatcher.cpp \
+                   ../../../Classes/FirebaseReadCache.cpp \
+                   ../../../Classes/FirebaseRequestPipeline.cpp \
+                   ../../../Classes/FirebaseLocalBackend.cpp \
+                   ../../../Classes/FirebaseReplay.cpp \
+                   ../../../Classes/FirebaseMemoryTracker.cpp \
+                   ../../../Classes/FirebaseFramePacer.cpp \
+                   ../../../Classes/FirebaseLazyModule.cpp \
+                   ../../../Classes/FirebaseStartup.cpp \
+                   ../../../Classes/FirebaseCompletionDispatcher.cpp \
+                   ../../../Classes/FirebaseBenchmark.cpp \
+                   ../../../Classes/FirebaseTrace.cpp \
+                   ../../../Classes/FirebaseProfiler.cpp \
+                   ../../../Classes/FirebaseBinaryLog.cpp \
+                   ../../../Classes/FirebaseLogQueue.cpp \
+                   ../../../Classes/FirebaseLogBuffer.cpp \
+                   ../../../Classes/FirebaseHostScene.cpp \
+                   ../../../Classes/FirebaseAdMobScene.cpp \
+                   ../../../Classes/FirebaseAnalyticsScene.cpp \
+                   ../../../Classes/FirebaseAuthScene.cpp \
+                   ../../../Classes/FirebaseDatabaseScene.cpp \
+                   ../../../Classes/FirebaseInvitesScene.cpp \
+                   ../../../Classes/FirebaseMessagingScene.cpp \
+                   ../../../Classes/FirebaseRemoteConfigScene.cpp \
+                   ../../../Classes/FirebaseStorageScene.cpp \
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../../Classes
+
+# Link every sample scene into one app behind the host menu.
+LOCAL_CFLAGS += -DFIREBASE_COCOS_HOST_APP
+
+# _COCOS_HEADER_ANDROID_BEGIN
+# _COCOS_HEADER_ANDROID_END
+
+LOCAL_STATIC_LIBRARIES := cocos2dx_static
+LOCAL_STATIC_LIBRARIES += firebase_admob
+LOCAL_STATIC_LIBRARIES += firebase_analytics
+LOCAL_STATIC_LIBRARIES += firebase_auth
+LOCAL_STATIC_LIBRARIES += firebase_database
+LOCAL_STATIC_LIBRARIES += firebase_invites
+LOCAL_STATIC_LIBRARIES += firebase_messaging
+LOCAL_STATIC_LIBRARIES += firebase_remote_config
+LOCAL_STATIC_LIBRARIES += firebase_storage
+LOCAL_STATIC_LIBRARIES += firebase_app
+
+# _COCOS_LIB_ANDROID_BEGIN
+# _COCOS_LIB_ANDROID_END
+
+include $(BUILD_SHARED_LIBRARY)
+
+$(call import-module,.)
+
+# _COCOS_LIB_IMPORT_ANDROID_BEGIN
+# _COCOS_LIB_IMPORT_ANDROID_END
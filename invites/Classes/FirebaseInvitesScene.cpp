@@ -29,6 +29,8 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseLazyModule.h"
 #include "firebase/future.h"
 #include "firebase/invites.h"
 
@@ -40,10 +42,21 @@ static const float kUIElementPadding = 10.0;
 /// The title text for the Firebase buttons.
 static const char* kInviteButtonText = "Invite";
 
+/// Initializes Firebase Invites. Called when the first invite is sent.
+static firebase::InitResult initializeInvites(firebase::App* app) {
+  CCLOG("Initializing the Invites with Firebase API.");
+  return firebase::invites::Initialize(*app);
+}
+
+/// Invites is only initialized once an invite is sent.
+static FirebaseLazyModule invitesModule("Invites", initializeInvites);
+
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseInvitesScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseInvitesScene.
 Scene* FirebaseInvitesScene::createScene() {
@@ -68,10 +81,6 @@ bool FirebaseInvitesScene::init() {
   auto visibleSize = Director::getInstance()->getVisibleSize();
   cocos2d::Vec2 origin = Director::getInstance()->getVisibleOrigin();
 
-  // Intitialize Firebase Invites.
-  CCLOG("Initializing the Invites with Firebase API.");
-  firebase::invites::Initialize(*firebase::App::GetInstance());
-
   // Create the Firebase label.
   auto firebaseLabel =
       Label::createWithTTF("Firebase Invites", "fonts/Marker Felt.ttf", 20);
@@ -94,14 +103,10 @@ bool FirebaseInvitesScene::init() {
   invite_button_ = createButton(true, kInviteButtonText);
   invite_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Invites invite button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
-            firebase::invites::Invite invite;
-            invite.title_text = "Invite Friends";
-            invite.message_text = "Try out this super cool sample app!";
-            invite.call_to_action_text = "Download now!";
-            firebase::invites::SendInvite(invite);
-            invite_sent_ = true;
+            invitesModule.use(this, [this]() { this->sendInvite(); });
             break;
           }
           default: {
@@ -127,42 +132,47 @@ bool FirebaseInvitesScene::init() {
   menu->setPosition(cocos2d::Vec2::ZERO);
   this->addChild(menu, 1);
 
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
-
   return true;
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
-void FirebaseInvitesScene::update(float /*delta*/) {
-  if (invite_sent_) {
-    firebase::Future<firebase::invites::SendInviteResult> future =
-        firebase::invites::SendInviteLastResult();
-    if (future.Status() == firebase::kFutureStatusComplete) {
-      if (future.Error() == 0) {
-        const firebase::invites::SendInviteResult& result = *future.Result();
-        if (result.invitation_ids.size() > 0) {
-          // One or more invitations were sent. You can log the invitation IDs
-          // here for analytics purposes, as they will be the same on the
-          // receiving side.
-          logMessage("Invite sent successfully!");
-        }
-        else {
-          // Zero invitations were sent. This tells us that the user canceled
-          // sending invitations.
-          logMessage("Invite canceled.");
-        }
-      } else {
-        // error() is nonzero, which means an error occurred. You can check
-        // future_result.error_message() for more information.
-        logMessage("Error sending the invite. (Error %i: \"%s\")",
-            future.Error(), future.ErrorMessage());
-      }
-      invite_sent_ = false;
-    } else {
-      // The SendInvite() operation has not completed yet, which means the
-      // Invites client UI is still on screen. Check the status() again soon.
+void FirebaseInvitesScene::sendInvite() {
+  firebase::invites::Invite invite;
+  invite.title_text = "Invite Friends";
+  invite.message_text = "Try out this super cool sample app!";
+  invite.call_to_action_text = "Download now!";
+  firebase::invites::SendInvite(invite);
+  // The Future completes once the Invites client UI is dismissed.
+  FirebaseCompletionDispatcher::onCompletion(
+      firebase::invites::SendInviteLastResult(), this,
+      CC_CALLBACK_1(FirebaseInvitesScene::onSendInviteComplete, this),
+      FirebaseTrace::begin("Invites SendInvite"));
+}
+
+// Futures are handled by completion callbacks, so there is nothing to poll and
+// the update is not scheduled.
+void FirebaseInvitesScene::update(float /*delta*/) {}
+
+void FirebaseInvitesScene::onSendInviteComplete(
+    const firebase::Future<firebase::invites::SendInviteResult>& future) {
+  if (future.Error() == 0) {
+    const firebase::invites::SendInviteResult& result = *future.Result();
+    if (result.invitation_ids.size() > 0) {
+      // One or more invitations were sent. You can log the invitation IDs
+      // here for analytics purposes, as they will be the same on the
+      // receiving side.
+      logMessage("Invite sent successfully!");
     }
+    else {
+      // Zero invitations were sent. This tells us that the user canceled
+      // sending invitations.
+      logMessage("Invite canceled.");
+    }
+  } else {
+    // error() is nonzero, which means an error occurred. You can check
+    // future_result.error_message() for more information.
+    FIREBASE_COCOS_LOG_ERROR(this,
+                             "Error sending the invite. (Error %i: \"%s\")",
+                             future.Error(), future.ErrorMessage());
   }
 }
 
@@ -170,10 +180,5 @@ void FirebaseInvitesScene::update(float /*delta*/) {
 void FirebaseInvitesScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Invites C++ resources.");
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
@@ -26,10 +26,12 @@
 
 #include "FirebaseCocos.h"
 #include "FirebaseScene.h"
+#include "firebase/future.h"
+#include "firebase/invites.h"
 
 class FirebaseInvitesScene : public FirebaseScene {
  public:
-  FirebaseInvitesScene() : invite_button_(nullptr), invite_sent_(false) {}
+  FirebaseInvitesScene() : invite_button_(nullptr) {}
 
   static cocos2d::Scene *createScene();
 
@@ -45,8 +47,13 @@ class FirebaseInvitesScene : public FirebaseScene {
   /// The button for loading an ad view.
   cocos2d::ui::Button* invite_button_;
 
-  /// Keep track of whether an invite has been sent.
-  bool invite_sent_;
+  /// Shows the Invites client UI. Invites must be initialized.
+  void sendInvite();
+
+  /// Called when the SendInvite() operation completes, which happens once the
+  /// Invites client UI has been dismissed.
+  void onSendInviteComplete(
+      const firebase::Future<firebase::invites::SendInviteResult>& future);
 };
 
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_INVITES_SCENE_H_
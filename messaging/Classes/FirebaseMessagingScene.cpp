@@ -29,6 +29,7 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseReplay.h"
 #include "firebase/messaging.h"
 
 USING_NS_CC;
@@ -36,12 +37,76 @@ USING_NS_CC;
 /// Padding for the UI elements.
 static const float kUIElementPadding = 10.0;
 
-class FirebaseMessagingSceneListener : public firebase::messaging::Listener {
+/// The FirebaseReplay channels of the listener's callbacks.
+static const char kMessageChannel[] = "messaging.message";
+static const char kTokenChannel[] = "messaging.token";
+
+/// The number of fields a message is recorded with before its data pairs.
+static const size_t kMessageFieldCount = 11;
+
+/// Returns the fields FirebaseReplay records `message` with: from, error,
+/// message_id, whether there is a notification, the notification's fields,
+/// then the data as key and value pairs.
+static FirebaseReplay::Fields messageFields(
+    const firebase::messaging::Message& message) {
+  static const firebase::messaging::Notification kNoNotification =
+      firebase::messaging::Notification();
+  const firebase::messaging::Notification& notification =
+      message.notification ? *message.notification : kNoNotification;
+  FirebaseReplay::Fields fields = {message.from,
+                                   message.error,
+                                   message.message_id,
+                                   message.notification ? "1" : "0",
+                                   notification.title,
+                                   notification.body,
+                                   notification.icon,
+                                   notification.tag,
+                                   notification.color,
+                                   notification.sound,
+                                   notification.click_action};
+  for (const auto& field : message.data) {
+    fields.push_back(field.first);
+    fields.push_back(field.second);
+  }
+  return fields;
+}
+
+/// Rebuilds the message recorded by messageFields(). The message's
+/// notification, if any, is pointed at `notification`.
+static void messageFromFields(const FirebaseReplay::Fields& fields,
+                              firebase::messaging::Message* message,
+                              firebase::messaging::Notification* notification) {
+  message->from = fields[0];
+  message->error = fields[1];
+  message->message_id = fields[2];
+  if (fields[3] == "1") {
+    notification->title = fields[4];
+    notification->body = fields[5];
+    notification->icon = fields[6];
+    notification->tag = fields[7];
+    notification->color = fields[8];
+    notification->sound = fields[9];
+    notification->click_action = fields[10];
+    message->notification = notification;
+  }
+  for (size_t i = kMessageFieldCount; i + 1 < fields.size(); i += 2) {
+    message->data[fields[i]] = fields[i + 1];
+  }
+}
+
+class FirebaseMessagingSceneListener
+    : public firebase::messaging::Listener,
+      public FirebaseTracked<FirebaseMessagingSceneListener, true> {
  public:
   FirebaseMessagingSceneListener(FirebaseMessagingScene* scene)
       : scene_(scene) {}
 
+  static const char* trackedName() { return "FirebaseMessagingSceneListener"; }
+
   void OnMessage(const firebase::messaging::Message& message) override {
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(kMessageChannel, messageFields(message));
+    }
     scene_->logMessage("Recieved a new message");
     if (!message.from.empty()) {
       scene_->logMessage("from: %s", message.from.c_str());
@@ -96,6 +161,9 @@ class FirebaseMessagingSceneListener : public firebase::messaging::Listener {
     //
     // Once a token is generated is should be sent to your app server, which can
     // then use it to send messages to users.
+    if (FirebaseReplay::isRecording()) {
+      FirebaseReplay::record(kTokenChannel, {token ? token : ""});
+    }
     scene_->logMessage("Recieved Registration Token: %s", token);
   }
 
@@ -103,10 +171,12 @@ class FirebaseMessagingSceneListener : public firebase::messaging::Listener {
   FirebaseMessagingScene* scene_;
 };
 
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseMessagingScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseMessagingScene.
 Scene* FirebaseMessagingScene::createScene() {
@@ -151,9 +221,12 @@ bool FirebaseMessagingScene::init() {
 
   // Intitialize Firebase Messaging. (This must happen after the log ui widget
   // is set up so that the listener has a place to send log messages to)
+  // Unlike Analytics and Invites this is not deferred with FirebaseLazyModule:
+  // the listener has to be registered at launch to receive the token and any
+  // message that opened the app.
   CCLOG("Initializing the Messaging with Firebase API.");
-  firebase::messaging::Initialize(*firebase::App::GetInstance(),
-                                  new FirebaseMessagingSceneListener(this));
+  listener_ = new FirebaseMessagingSceneListener(this);
+  firebase::messaging::Initialize(*firebase::App::GetInstance(), listener_);
 
   // Create the close app menu item.
   auto closeAppItem = MenuItemImage::create(
@@ -171,23 +244,37 @@ bool FirebaseMessagingScene::init() {
   menu->setPosition(cocos2d::Vec2::ZERO);
   this->addChild(menu, 1);
 
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
+  // Replayed callbacks are handed to the same listener.
+  FirebaseReplay::setHandler(
+      kMessageChannel, this, [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < kMessageFieldCount) return;
+        firebase::messaging::Message message;
+        firebase::messaging::Notification notification;
+        messageFromFields(fields, &message, &notification);
+        listener_->OnMessage(message);
+        // The notification is on the stack, so don't let the message own it.
+        message.notification = nullptr;
+      });
+  FirebaseReplay::setHandler(
+      kTokenChannel, this, [this](const FirebaseReplay::Fields& fields) {
+        if (fields.empty()) return;
+        listener_->OnTokenReceived(fields[0].c_str());
+      });
 
   return true;
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
+// There is nothing to do each frame, so the update is not scheduled.
 void FirebaseMessagingScene::update(float /*delta*/) {}
 
 /// Handles the user tapping on the close app menu item.
 void FirebaseMessagingScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Messaging C++ resources.");
+  // Stop the listener, which refers to this scene, from being called.
+  FirebaseReplay::removeHandlers(this);
+  firebase::messaging::Terminate();
+  delete listener_;
+  listener_ = nullptr;
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
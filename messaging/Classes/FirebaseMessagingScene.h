@@ -27,8 +27,12 @@
 #include "FirebaseCocos.h"
 #include "FirebaseScene.h"
 
+class FirebaseMessagingSceneListener;
+
 class FirebaseMessagingScene : public FirebaseScene {
  public:
+  FirebaseMessagingScene() : listener_(nullptr) {}
+
   static cocos2d::Scene *createScene();
 
   bool init() override;
@@ -38,6 +42,10 @@ class FirebaseMessagingScene : public FirebaseScene {
   void menuCloseAppCallback(cocos2d::Ref *pSender) override;
 
   CREATE_FUNC(FirebaseMessagingScene);
+
+ private:
+  /// Receives the messages and token. Owned by the scene.
+  FirebaseMessagingSceneListener* listener_;
 };
 
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_MESSAGING_SCENE_H_
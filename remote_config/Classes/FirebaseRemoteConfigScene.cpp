@@ -29,6 +29,7 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
 #include "firebase/remote_config.h"
 #include "firebase/variant.h"
 
@@ -37,10 +38,12 @@ USING_NS_CC;
 /// Padding for the UI elements.
 static const float kUIElementPadding = 10.0;
 
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseRemoteConfigScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseRemoteConfigScene.
 Scene* FirebaseRemoteConfigScene::createScene() {
@@ -127,7 +130,7 @@ bool FirebaseRemoteConfigScene::init() {
   }
   {
     int64_t result = remote_config::GetLong("TestLong");
-    logMessage("Get TestLong %lld", result);
+    logMessage("Get TestLong %lld", static_cast<long long>(result));
   }
   {
     double result = remote_config::GetDouble("TestDouble");
@@ -141,7 +144,7 @@ bool FirebaseRemoteConfigScene::init() {
     std::vector<unsigned char> result = remote_config::GetData("TestData");
     for (size_t i = 0; i < result.size(); ++i) {
       const unsigned char value = result[i];
-      logMessage("TestData[%d] = 0x%02x", i, value);
+      logMessage("TestData[%d] = 0x%02x", static_cast<int>(i), value);
     }
   }
 
@@ -155,21 +158,21 @@ bool FirebaseRemoteConfigScene::init() {
     logMessage("Failed to enable developer mode");
   }
 
-  future_ = remote_config::Fetch(0);
-
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
+  FirebaseCompletionDispatcher::onCompletion(
+      remote_config::Fetch(0), this,
+      CC_CALLBACK_1(FirebaseRemoteConfigScene::onFetchComplete, this),
+      FirebaseTrace::begin("Remote Config Fetch"));
 
   return true;
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
-void FirebaseRemoteConfigScene::update(float /*delta*/) {
-  namespace remote_config = ::firebase::remote_config;
+// Futures are handled by completion callbacks, so there is nothing to poll and
+// the update is not scheduled.
+void FirebaseRemoteConfigScene::update(float /*delta*/) {}
 
-  if (future_.status() != firebase::kFutureStatusComplete) {
-    return;
-  }
+void FirebaseRemoteConfigScene::onFetchComplete(
+    const firebase::Future<void>& /*future*/) {
+  namespace remote_config = ::firebase::remote_config;
 
   logMessage("Fetch Complete");
   bool activate_result = remote_config::ActivateFetched();
@@ -187,7 +190,7 @@ void FirebaseRemoteConfigScene::update(float /*delta*/) {
   }
   {
     int64_t result = remote_config::GetLong("TestLong");
-    logMessage("Updated TestLong %lld", result);
+    logMessage("Updated TestLong %lld", static_cast<long long>(result));
   }
   {
     double result = remote_config::GetDouble("TestDouble");
@@ -201,7 +204,7 @@ void FirebaseRemoteConfigScene::update(float /*delta*/) {
     std::vector<unsigned char> result = remote_config::GetData("TestData");
     for (size_t i = 0; i < result.size(); ++i) {
       const unsigned char value = result[i];
-      logMessage("TestData[%d] = 0x%02x", i, value);
+      logMessage("TestData[%d] = 0x%02x", static_cast<int>(i), value);
     }
   }
 
@@ -216,22 +219,15 @@ void FirebaseRemoteConfigScene::update(float /*delta*/) {
   for (auto s = keys.begin(); s != keys.end(); ++s) {
     logMessage("  %s", s->c_str());
   }
-
-  // Release a handle to the future so we can shutdown the Remote Config API
-  // when exiting the app. Alternatively we could have placed future in a scope
-  // different to our shutdown code below.
-  future_.Release();
 }
 
 /// Handles the user tapping on the close app menu item.
 void FirebaseRemoteConfigScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Remote Config C++ resources.");
+  // The Fetch may still be in flight. Drop its callback first so that
+  // onFetchComplete() never calls into Remote Config after Terminate().
+  FirebaseCompletionDispatcher::dropOwner(this);
   firebase::remote_config::Terminate();
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
@@ -40,10 +40,9 @@ class FirebaseRemoteConfigScene : public FirebaseScene {
 
   CREATE_FUNC(FirebaseRemoteConfigScene);
  private:
-
-  // The future returned from calling remote_config::Fetch. The future created
-  // then polled in the update loop until the data is returned.
-  firebase::Future<void> future_;
+  /// Called when the Future returned from calling remote_config::Fetch
+  /// completes. Activates the fetched data and logs the new values.
+  void onFetchComplete(const firebase::Future<void>& future);
 };
 
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_REMOTE_CONFIG_SCENE_H_
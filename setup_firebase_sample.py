@@ -32,7 +32,11 @@ Run the script:
 
 Where FIREBASE_FEATURE is one of the following:
 
-  AdMob, Analytics, Auth, Database, Invites, Messaging, Remote_Config or Storage
+  AdMob, Analytics, Auth, Database, Invites, Messaging, Remote_Config, Storage
+  or Host
+
+Host sets up a single app that links every feature's scene and opens them from
+a menu, to measure the cost of all of the Firebase modules together.
 """
 
 import argparse
@@ -77,6 +81,11 @@ FIREBASE_FEATURES_ARRAY = [
     "Messaging",
     "Remote_Config",
     "Storage",
+    "Host",
+]
+# The Firebase features linked into the Host app.
+HOST_FEATURES_ARRAY = [
+    feature for feature in FIREBASE_FEATURES_ARRAY if feature != "Host"
 ]
 # The path to the Firebase SDK to use. This is optional, if left blank the most
 # recent release will be downloaded and used.
@@ -279,6 +288,8 @@ def add_resource_files():
 def add_class_files():
   """Adds the C++ class files to the sample project's Classes directory.
 
+  The Host app gets the class files of every feature as well as its own.
+
   Raises:
     IOError: An error occurred copying the class files.
   """
@@ -286,19 +297,22 @@ def add_class_files():
   common_classes_dir = os.path.join(ROOT_DIRECTORY, "common/Classes")
   third_party_classes_glob = os.path.join(
       ROOT_DIRECTORY, "third_party/cocos2dx/common/Classes/*")
-  feature_classes_dir = os.path.join(ROOT_DIRECTORY, firebase_feature,
-                                     "Classes")
+  features = [firebase_feature]
+  if firebase_feature == "host":
+    features += [feature.lower() for feature in HOST_FEATURES_ARRAY]
   dst_dir = os.path.join(ROOT_DIRECTORY, "sample_project/Classes")
   try:
     shutil.rmtree(dst_dir)
     shutil.copytree(common_classes_dir, dst_dir)
     for file in glob.glob(third_party_classes_glob):
       shutil.copy(file, dst_dir)
-    feature_classes_files = os.listdir(feature_classes_dir)
-    for file_name in feature_classes_files:
-      full_file_name = os.path.join(feature_classes_dir, file_name)
-      if os.path.isfile(full_file_name):
-        shutil.copy(full_file_name, dst_dir)
+    for feature in features:
+      feature_classes_dir = os.path.join(ROOT_DIRECTORY, feature, "Classes")
+      feature_classes_files = os.listdir(feature_classes_dir)
+      for file_name in feature_classes_files:
+        full_file_name = os.path.join(feature_classes_dir, file_name)
+        if os.path.isfile(full_file_name):
+          shutil.copy(full_file_name, dst_dir)
   except IOError as e:
     logging.exception("IOError: [Errno %d] %s: in %s", e.errno, e.strerror,
                       sys._getframe().f_code.co_name)
@@ -360,7 +374,8 @@ def check_valid_arguments():
       metavar="FIREBASE_FEATURE",
       nargs=1,
       help="The Firebase feature must be one of the following: "
-      "AdMob, Analytics, Auth, Invites, Messaging, or Remote_Config")
+      "AdMob, Analytics, Auth, Database, Invites, Messaging, Remote_Config, "
+      "Storage or Host")
   parser.add_argument(
       "--firebase_sdk",
       action='store',
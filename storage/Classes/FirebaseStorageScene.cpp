@@ -21,6 +21,11 @@
 #include "FirebaseStorageScene.h"
 
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include <android/log.h>
@@ -29,6 +34,9 @@
 #endif
 
 #include "FirebaseCocos.h"
+#include "FirebaseCompletionDispatcher.h"
+#include "FirebaseLocalBackend.h"
+#include "FirebaseReplay.h"
 #include "firebase/auth.h"
 #include "firebase/storage.h"
 #include "firebase/future.h"
@@ -44,21 +52,50 @@ static const char* kValuePlaceholderText = "Value";
 
 static const char* kTestAppData = "test_app_data";
 
+/// The FirebaseReplay channel of StorageListener::OnProgress.
+static const char kProgressChannel[] = "storage.progress";
+
 void StorageListener::OnPaused(firebase::storage::Controller*) {}
 
 void StorageListener::OnProgress(firebase::storage::Controller* controller) {
-  int transferred = controller->bytes_transferred();
-  int total = controller->total_byte_count();
-  if (total > 0) {
-    int percent = 100 * transferred / total;
-    scene_->logMessage("Transfer %i%% (%i/%i)", percent, transferred, total);
+  // Leave the controller alone unless the progress is logged or recorded.
+  const bool recording = FirebaseReplay::isRecording();
+  if (!recording &&
+      !FirebaseScene::isLogLevelEnabled(FirebaseScene::kLogLevelInfo)) {
+    return;
+  }
+  const int64_t transferred = controller->bytes_transferred();
+  const int64_t total = controller->total_byte_count();
+  if (recording) {
+    FirebaseReplay::record(kProgressChannel,
+                           {FirebaseReplay::formatInt(transferred),
+                            FirebaseReplay::formatInt(total)});
+  }
+  logProgress(transferred, total);
+}
+
+void StorageListener::logProgress(int transferred, int total) {
+  if (total <= 0) return;
+  const int percent = static_cast<int>(100LL * transferred / total);
+  // Progress is reported many times per transfer, so only the first report
+  // in each tenth of it is logged, which includes the start and the end; the
+  // rest are traced. A transfer starting over moves to a new tenth too.
+  const int step = percent / 10;
+  if (lastLoggedStep_.exchange(step, std::memory_order_relaxed) != step) {
+    FIREBASE_COCOS_LOG_INFO(scene_, "Transfer %i%% (%i/%i)", percent,
+                            transferred, total);
+  } else {
+    FIREBASE_COCOS_LOG_TRACE(scene_, "Transfer %i%% (%i/%i)", percent,
+                             transferred, total);
   }
 }
 
+#if !defined(FIREBASE_COCOS_HOST_APP)
 /// Creates the Firebase scene.
 Scene* CreateFirebaseScene() {
   return FirebaseStorageScene::createScene();
 }
+#endif  // !defined(FIREBASE_COCOS_HOST_APP)
 
 /// Creates the FirebaseStorageScene.
 Scene* FirebaseStorageScene::createScene() {
@@ -103,6 +140,13 @@ bool FirebaseStorageScene::init() {
       ->performFunctionInCocosThread(
           [=]() { this->createScrollView(scrollViewYPosition); });
 
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+  // The local backend stands in for Auth and Storage.
+  auth_ = nullptr;
+  storage_ = nullptr;
+  initializeAndSignIn();
+  logMessage("Using the local backend instead of Firebase Storage.");
+#else
   // Use ModuleInitializer to initialize both Auth and Storage, ensuring no
   // dependencies are missing.
   void* initialize_targets[] = {&auth_, &storage_};
@@ -127,15 +171,17 @@ bool FirebaseStorageScene::init() {
   // There are two ways to track long running operations: (1) retrieve the
   // future using a LastResult function or (2) Cache the future manually.
   //
-  // Here we use method 1: the future is not cached but will be later retrieved
-  // using InitializeLastResult. Which method is best for your app depends on
-  // your use case.
+  // Here we use method 1: the future is not cached but is retrieved using
+  // InitializeLastResult in initializeAndSignIn. Which method is best for your
+  // app depends on your use case.
   initializer_.Initialize(
       firebase::App::GetInstance(), initialize_targets, initializers,
       sizeof(initializers) / sizeof(initializers[0]));
+  initializeAndSignIn();
 
   logMessage("Created the Storage %x class for the Firebase app.",
              static_cast<int>(reinterpret_cast<intptr_t>(storage_)));
+#endif  // defined(FIREBASE_COCOS_LOCAL_BACKEND)
 
   key_text_field_ = createTextField(kKeyPlaceholderText);
   this->addChild(key_text_field_);
@@ -146,23 +192,16 @@ bool FirebaseStorageScene::init() {
   get_bytes_button_ = createButton(false, "Query");
   get_bytes_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Storage get bytes button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
-            const char* key = key_text_field_->getString().c_str();
-            firebase::storage::StorageReference reference =
-                this->storage_->GetReference(kTestAppData).Child(key);
-            this->logMessage("Querying key `%s`.", key);
-            // There are two ways to track long running operations:
-            // (1) retrieve the future using a LastResult function or (2) Cache
-            // the future manually.
-            //
-            // Here (and below in the put_bytes_button_) we use method 2:
-            // caching the future. Which method is best for your app depends on
-            // your use case.
-            get_bytes_future_ = reference.GetBytes(
-                this->byte_buffer_, kBufferSize, &this->listener_);
-            this->get_bytes_button_->setEnabled(false);
-            this->put_bytes_button_->setEnabled(false);
+            const std::string key = key_text_field_->getString();
+            this->logMessage("Queueing %d reads of key `%s`.",
+                             pipeline_.getBurstSize(), key.c_str());
+            pipeline_.pushBurst(
+                [this, key](const FirebaseRequestPipeline::Done& done) {
+                  this->startGetBytes(key, done);
+                });
             break;
           }
           default: {
@@ -175,18 +214,18 @@ bool FirebaseStorageScene::init() {
   put_bytes_button_ = createButton(false, "Set");
   put_bytes_button_->addTouchEventListener(
       [this](Ref* /*sender*/, cocos2d::ui::Widget::TouchEventType type) {
+        FIREBASE_COCOS_PROFILE_SCOPE("Storage put bytes button");
         switch (type) {
           case cocos2d::ui::Widget::TouchEventType::ENDED: {
-            const char* key = key_text_field_->getString().c_str();
-            const char* value = value_text_field_->getString().c_str();
-            size_t value_size = value_text_field_->getString().size();
-            firebase::storage::StorageReference reference =
-                this->storage_->GetReference(kTestAppData).Child(key);
-            this->logMessage("Setting key `%s` to `%s`.", key, value);
-            this->put_bytes_future_ = reference.PutBytes(value, value_size,
-                                                         &this->listener_);
-            this->get_bytes_button_->setEnabled(false);
-            this->put_bytes_button_->setEnabled(false);
+            const std::string key = key_text_field_->getString();
+            const std::string value = value_text_field_->getString();
+            this->logMessage("Queueing %d writes of `%s` to key `%s`.",
+                             pipeline_.getBurstSize(), value.c_str(),
+                             key.c_str());
+            pipeline_.pushBurst(
+                [this, key, value](const FirebaseRequestPipeline::Done& done) {
+                  this->startPutBytes(key, value, done);
+                });
             break;
           }
           default: {
@@ -196,6 +235,8 @@ bool FirebaseStorageScene::init() {
       });
   this->addChild(put_bytes_button_);
 
+  createRequestPipelineControls(&pipeline_);
+
   // Create the close app menu item.
   auto closeAppItem = MenuItemImage::create(
       "CloseNormal.png", "CloseSelected.png",
@@ -212,104 +253,201 @@ bool FirebaseStorageScene::init() {
   menu->setPosition(cocos2d::Vec2::ZERO);
   this->addChild(menu, 1);
 
-  state_ = kStateInitialize;
-
-  // Schedule the update method for this scene.
-  this->scheduleUpdate();
+  // Replayed progress goes to the same listener.
+  FirebaseReplay::setHandler(
+      kProgressChannel, this, [this](const FirebaseReplay::Fields& fields) {
+        if (fields.size() < 2) return;
+        listener_.logProgress(atoi(fields[0].c_str()),
+                              atoi(fields[1].c_str()));
+      });
 
   return true;
 }
 
-FirebaseStorageScene::State FirebaseStorageScene::updateInitialize() {
-  firebase::Future<void> initialize_future =
-      initializer_.InitializeLastResult();
-  if (initialize_future.status() != firebase::kFutureStatusComplete) {
-    return kStateInitialize;
-  }
-  if (initialize_future.error() != 0) {
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+void FirebaseStorageScene::initializeAndSignIn() {
+  FirebaseLocalBackend::signInAnonymously(
+      this,
+      [this](const FirebaseLocalBackend::Result& result) {
+        onSignInResult(result.error, result.errorMessage.c_str());
+      },
+      FirebaseTrace::begin("Auth SignInAnonymously"));
+}
+#else
+void FirebaseStorageScene::initializeAndSignIn() {
+  FirebaseCompletionDispatcher::onCompletion(
+      initializer_.InitializeLastResult(), this,
+      [this](const firebase::Future<void>& future) {
+        if (!onInitializeComplete(future)) return;
+        // Sign in using Auth before accessing the storage.
+        //
+        // The default Storage permissions allow anonymous user access.
+        // However, Firebase Auth does not allow anonymous user login by
+        // default. This setting can be changed in the Auth settings page for
+        // your project in the Firebase Console under the "Sign-In Method" tab.
+        FirebaseCompletionDispatcher::onCompletion(
+            auth_->SignInAnonymously(), this,
+            CC_CALLBACK_1(FirebaseStorageScene::onSignInComplete, this),
+            FirebaseTrace::begin("Auth SignInAnonymously"));
+      },
+      FirebaseTrace::begin("Storage ModuleInitializer"));
+}
+#endif
+
+bool FirebaseStorageScene::onInitializeComplete(
+    const firebase::Future<void>& future) {
+  if (future.error() != 0) {
     logMessage("Failed to initialize Firebase libraries: %s",
-               initialize_future.error_message());
-    return kStateRun;
+               future.error_message());
+    return false;
   }
   logMessage("Successfully initialized Firebase Auth and Firebase Storage.");
-  auth_->SignInAnonymously();
-  return kStateLogin;
+  return true;
 }
 
-FirebaseStorageScene::State FirebaseStorageScene::updateLogin() {
-  // Sign in using Auth before accessing the storage.
-  //
-  // The default Storage permissions allow anonymous user access. However,
-  // Firebase Auth does not allow anonymous user login by default. This setting
-  // can be changed in the Auth settings page for your project in the Firebase
-  // Console under the "Sign-In Method" tab.
-  firebase::Future<firebase::auth::User*> sign_in_future =
-      auth_->SignInAnonymouslyLastResult();
-  if (sign_in_future.status() != firebase::kFutureStatusComplete) {
-    return kStateLogin;
-  }
-  if (sign_in_future.error() != firebase::auth::kAuthErrorNone) {
-    logMessage("ERROR: Could not sign in anonymously. Error %d: %s",
-               sign_in_future.error(), sign_in_future.error_message());
+void FirebaseStorageScene::onSignInComplete(
+    const firebase::Future<firebase::auth::User*>& future) {
+  onSignInResult(future.error(), future.error_message());
+}
+
+void FirebaseStorageScene::onSignInResult(int error,
+                                          const char* error_message) {
+  if (error != firebase::auth::kAuthErrorNone) {
+    FIREBASE_COCOS_LOG_ERROR(this,
+                             "Could not sign in anonymously. Error %d: %s",
+                             error, error_message);
     logMessage(
         "Ensure your application has the Anonymous sign-in provider enabled in "
         "the Firebase Console.");
-    return kStateRun;
+    return;
   }
   logMessage("Auth: Signed in anonymously.");
   get_bytes_button_->setEnabled(true);
   put_bytes_button_->setEnabled(true);
-  return kStateRun;
 }
 
-FirebaseStorageScene::State FirebaseStorageScene::updateRun() {
-  if (get_bytes_future_.status() == firebase::kFutureStatusComplete) {
-    if (get_bytes_future_.error() == firebase::storage::kErrorNone) {
-      logMessage("GetBytes complete");
-      const size_t* length = get_bytes_future_.result();
-      logMessage("Got %i bytes: %s", static_cast<int>(*length), byte_buffer_);
-    } else {
-      logMessage("ERROR: Could not get bytes. Error %d: %s",
-                 get_bytes_future_.error(), get_bytes_future_.error_message());
-    }
-    get_bytes_button_->setEnabled(true);
-    put_bytes_button_->setEnabled(true);
-    get_bytes_future_.Release();
-  }
-  if (put_bytes_future_.status() == firebase::kFutureStatusComplete) {
-    if (put_bytes_future_.error() == firebase::storage::kErrorNone) {
-      logMessage("PutBytes complete.");
-      const firebase::storage::Metadata* metadata = put_bytes_future_.result();
-      logMessage("Put %i bytes", static_cast<int>(metadata->size_bytes()));
-    } else {
-      logMessage("ERROR: Could not put bytes. Error %d: %s",
-                 put_bytes_future_.error(), put_bytes_future_.error_message());
-    }
-    get_bytes_button_->setEnabled(true);
-    put_bytes_button_->setEnabled(true);
-    put_bytes_future_.Release();
+void FirebaseStorageScene::onGetBytesComplete(
+    const firebase::Future<size_t>& future) {
+  const size_t* length = future.result();
+  onGetBytesResult(future.error(), future.error_message(),
+                   length ? *length : 0);
+}
+
+void FirebaseStorageScene::onGetBytesResult(int error,
+                                            const char* error_message,
+                                            size_t length) {
+  if (error == firebase::storage::kErrorNone) {
+    logMessage("GetBytes complete");
+    logMessage("Got %i bytes: %s", static_cast<int>(length), byte_buffer_);
+  } else {
+    FIREBASE_COCOS_LOG_ERROR(this, "Could not get bytes. Error %d: %s",
+                             error, error_message);
   }
-  return kStateRun;
 }
 
-// Called automatically every frame. The update is scheduled in `init()`.
-void FirebaseStorageScene::update(float /*delta*/) {
-  switch (state_) {
-    case kStateInitialize: state_ = updateInitialize(); break;
-    case kStateLogin: state_ = updateLogin(); break;
-    case kStateRun: state_ = updateRun(); break;
-    default: assert(0);
+void FirebaseStorageScene::onPutBytesComplete(
+    const firebase::Future<firebase::storage::Metadata>& future) {
+  const firebase::storage::Metadata* metadata = future.result();
+  onPutBytesResult(future.error(), future.error_message(),
+                   metadata ? metadata->size_bytes() : 0);
+}
+
+void FirebaseStorageScene::onPutBytesResult(int error,
+                                            const char* error_message,
+                                            int64_t size) {
+  if (error == firebase::storage::kErrorNone) {
+    logMessage("PutBytes complete.");
+    logMessage("Put %i bytes", static_cast<int>(size));
+  } else {
+    FIREBASE_COCOS_LOG_ERROR(this, "Could not put bytes. Error %d: %s",
+                             error, error_message);
   }
 }
 
+size_t FirebaseStorageScene::setByteBuffer(const char* bytes, size_t length) {
+  // Keep the buffer terminated, since it is logged as a string.
+  length = std::min(length, kBufferSize - 1);
+  memcpy(byte_buffer_, bytes, length);
+  byte_buffer_[length] = '\0';
+  return length;
+}
+
+#if defined(FIREBASE_COCOS_LOCAL_BACKEND)
+void FirebaseStorageScene::startGetBytes(
+    const std::string& key, const FirebaseRequestPipeline::Done& done) {
+  FirebaseLocalBackend::getBytes(
+      std::string(kTestAppData) + "/" + key, this,
+      [this, done](const FirebaseLocalBackend::Result& result) {
+        const size_t length =
+            setByteBuffer(result.bytes.data(), result.bytes.size());
+        onGetBytesResult(result.error, result.errorMessage.c_str(), length);
+        done(result.error == firebase::storage::kErrorNone);
+      },
+      FirebaseTrace::begin("Storage GetBytes"));
+}
+
+void FirebaseStorageScene::startPutBytes(
+    const std::string& key, const std::string& value,
+    const FirebaseRequestPipeline::Done& done) {
+  FirebaseLocalBackend::putBytes(
+      std::string(kTestAppData) + "/" + key, value.data(), value.size(), this,
+      [this, done](const FirebaseLocalBackend::Result& result) {
+        const int64_t size =
+            result.value.is_null() ? 0 : result.value.int64_value();
+        onPutBytesResult(result.error, result.errorMessage.c_str(), size);
+        done(result.error == firebase::storage::kErrorNone);
+      },
+      FirebaseTrace::begin("Storage PutBytes"));
+}
+#else
+void FirebaseStorageScene::startGetBytes(
+    const std::string& key, const FirebaseRequestPipeline::Done& done) {
+  firebase::storage::StorageReference reference =
+      storage_->GetReference(kTestAppData).Child(key.c_str());
+  // GetBytes writes into the buffer until it completes, so each read has its
+  // own, kept alive by the callback.
+  std::shared_ptr<std::vector<char>> buffer =
+      std::make_shared<std::vector<char>>(kBufferSize);
+  // Rather than polling the future every frame, ask to be called back on the
+  // cocos thread once it completes.
+  FirebaseCompletionDispatcher::onCompletion(
+      reference.GetBytes(buffer->data(), buffer->size(), &listener_), this,
+      [this, buffer, done](const firebase::Future<size_t>& future) {
+        const size_t* length = future.result();
+        setByteBuffer(buffer->data(), length ? *length : 0);
+        onGetBytesComplete(future);
+        done(future.error() == firebase::storage::kErrorNone);
+      },
+      FirebaseTrace::begin("Storage GetBytes"));
+}
+
+void FirebaseStorageScene::startPutBytes(
+    const std::string& key, const std::string& value,
+    const FirebaseRequestPipeline::Done& done) {
+  firebase::storage::StorageReference reference =
+      storage_->GetReference(kTestAppData).Child(key.c_str());
+  // PutBytes reads from the buffer until it completes, so the callback keeps
+  // a copy of the value alive.
+  std::shared_ptr<std::string> bytes = std::make_shared<std::string>(value);
+  FirebaseCompletionDispatcher::onCompletion(
+      reference.PutBytes(bytes->data(), bytes->size(), &listener_), this,
+      [this, bytes, done](
+          const firebase::Future<firebase::storage::Metadata>& future) {
+        onPutBytesComplete(future);
+        done(future.error() == firebase::storage::kErrorNone);
+      },
+      FirebaseTrace::begin("Storage PutBytes"));
+}
+#endif  // defined(FIREBASE_COCOS_LOCAL_BACKEND)
+
+// Futures are handled by completion callbacks, so there is nothing to poll and
+// the update is not scheduled.
+void FirebaseStorageScene::update(float /*delta*/) {}
+
 /// Handles the user tapping on the close app menu item.
 void FirebaseStorageScene::menuCloseAppCallback(Ref* pSender) {
   CCLOG("Cleaning up Storage C++ resources.");
+  pipeline_.clear();
 
-  // Close the cocos2d-x game scene and quit the application.
-  Director::getInstance()->end();
-
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  exit(0);
-#endif
+  closeSample();
 }
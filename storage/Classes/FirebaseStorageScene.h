@@ -21,10 +21,17 @@
 #ifndef FIREBASE_COCOS_CLASSES_FIREBASE_STORAGE_SCENE_H_
 #define FIREBASE_COCOS_CLASSES_FIREBASE_STORAGE_SCENE_H_
 
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "cocos2d.h"
 #include "ui/CocosGUI.h"
 
 #include "FirebaseCocos.h"
+#include "FirebaseRequestPipeline.h"
 #include "FirebaseScene.h"
 #include "firebase/auth.h"
 #include "firebase/storage.h"
@@ -36,6 +43,7 @@ static const size_t kBufferSize = 1024;
 
 class StorageListener : public firebase::storage::Listener {
  public:
+  StorageListener() : scene_(nullptr), lastLoggedStep_(-1) {}
   virtual ~StorageListener() {}
 
   /// Called whenever a transferred is paused.
@@ -44,10 +52,16 @@ class StorageListener : public firebase::storage::Listener {
   /// Called repeatedly as a transfer is in progress.
   void OnProgress(firebase::storage::Controller* controller) override;
 
+  /// Logs the progress of a transfer each time it passes another tenth, and
+  /// traces every report. Also called for replayed progress.
+  void logProgress(int transferred, int total);
+
   void set_scene(FirebaseScene* scene) { scene_ = scene; }
 
  private:
   FirebaseScene* scene_;
+  /// The tenth of a transfer that progress was last logged at.
+  std::atomic<int> lastLoggedStep_;
 };
 
 class FirebaseStorageScene : public FirebaseScene {
@@ -63,26 +77,41 @@ class FirebaseStorageScene : public FirebaseScene {
   CREATE_FUNC(FirebaseStorageScene);
 
  private:
-  /// An enum that tracks what the operations the app should be keeping track
-  /// of. First the app initializes the library, then it logs in using Firebase
+  /// First the app initializes the library, then it logs in using Firebase
   /// Authentication, and then it listens for reads or writes to the storage.
-  enum State {
-    kStateInitialize,
-    kStateLogin,
-    kStateRun,
-  };
-
-  /// The update loop to run while initializing the app.
-  State updateInitialize();
-
-  /// The update loop to run while logging in.
-  State updateLogin();
-
-  /// The update loop to run once all setup is complete.
-  State updateRun();
-
-  /// Tracks the current state of the app through its setup and main loop.
-  State state_;
+  /// This runs the first two steps, each once the previous step's Future
+  /// completes.
+  void initializeAndSignIn();
+
+  /// Called when Auth and Storage have been initialized. Returns true if
+  /// initialization succeeded.
+  bool onInitializeComplete(const firebase::Future<void>& future);
+
+  /// Called when the anonymous sign in completes.
+  void onSignInComplete(const firebase::Future<firebase::auth::User*>& future);
+  void onSignInResult(int error, const char* error_message);
+
+  /// Called when a read started by the query button completes. The bytes
+  /// read are in byte_buffer_.
+  void onGetBytesComplete(const firebase::Future<size_t>& future);
+  void onGetBytesResult(int error, const char* error_message, size_t length);
+
+  /// Called when a write started by the set button completes.
+  void onPutBytesComplete(
+      const firebase::Future<firebase::storage::Metadata>& future);
+  void onPutBytesResult(int error, const char* error_message, int64_t size);
+
+  /// Start the operations of the query and set buttons, on Firebase or, with
+  /// FIREBASE_COCOS_LOCAL_BACKEND, on the local backend. They are requests of
+  /// `pipeline_`, and call `done` once their result has been handled.
+  void startGetBytes(const std::string& key,
+                     const FirebaseRequestPipeline::Done& done);
+  void startPutBytes(const std::string& key, const std::string& value,
+                     const FirebaseRequestPipeline::Done& done);
+
+  /// Copies the bytes of a finished read into byte_buffer_, truncating them to
+  /// fit, and returns the number copied.
+  size_t setByteBuffer(const char* bytes, size_t length);
 
   /// The ModuleInitializer is a utility class to make initializing multiple
   /// Firebase libraries easier.
@@ -94,18 +123,13 @@ class FirebaseStorageScene : public FirebaseScene {
   /// Firebase Storage, the entry point to all storage operations.
   firebase::storage::Storage* storage_;
 
-  /// A byte buffer for Firebase Storage to write to.
+  /// The bytes of the last read, for logging. Each read is given its own
+  /// buffer, since several may be in flight at once.
   char byte_buffer_[kBufferSize];
 
   /// A listener that responds to PutBytes and GetBytes progress.
   StorageListener listener_;
 
-  /// A future that completes when the DataSnapshot for a query is received.
-  firebase::Future<size_t> get_bytes_future_;
-
-  /// A future that completes when a databse write is complete.
-  firebase::Future<firebase::storage::Metadata> put_bytes_future_;
-
   /// A text field where a storage key string may be entered.
   cocos2d::ui::TextField* key_text_field_;
 
@@ -117,6 +141,9 @@ class FirebaseStorageScene : public FirebaseScene {
 
   /// A button that sets the key to the value, given by the text fields.
   cocos2d::ui::Button* put_bytes_button_;
+
+  /// Runs the reads and writes queued by the query and set buttons.
+  FirebaseRequestPipeline pipeline_;
 };
 
 #endif  // FIREBASE_COCOS_CLASSES_FIREBASE_STORAGE_SCENE_H_
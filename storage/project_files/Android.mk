@@ -38,6 +38,26 @@ LOCAL_MODULE_FILENAME := libMyGame
 LOCAL_SRC_FILES := hellocpp/main.cpp \
                    ../../../Classes/AppDelegate.cpp \
                    ../../../Classes/FirebaseScene.cpp \
+                   ../../../Classes/FirebaseChildSubscription.cpp \
+                   ../../../Classes/FirebaseChildCollection.cpp \
+                   ../../../Classes/FirebaseVariantTable.cpp \
+                   ../../../Classes/FirebaseValueSubscriptions.cpp \
+                   ../../../Classes/FirebaseWriteBatcher.cpp \
+                   ../../../Classes/FirebaseReadCache.cpp \
+                   ../../../Classes/FirebaseRequestPipeline.cpp \
+                   ../../../Classes/FirebaseLocalBackend.cpp \
+                   ../../../Classes/FirebaseReplay.cpp \
+                   ../../../Classes/FirebaseMemoryTracker.cpp \
+                   ../../../Classes/FirebaseFramePacer.cpp \
+                   ../../../Classes/FirebaseLazyModule.cpp \
+                   ../../../Classes/FirebaseStartup.cpp \
+                   ../../../Classes/FirebaseCompletionDispatcher.cpp \
+                   ../../../Classes/FirebaseBenchmark.cpp \
+                   ../../../Classes/FirebaseTrace.cpp \
+                   ../../../Classes/FirebaseProfiler.cpp \
+                   ../../../Classes/FirebaseBinaryLog.cpp \
+                   ../../../Classes/FirebaseLogQueue.cpp \
+                   ../../../Classes/FirebaseLogBuffer.cpp \
                    ../../../Classes/FirebaseStorageScene.cpp \
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../../Classes
@@ -25,7 +25,11 @@
 
 #include "AppDelegate.h"
 
+#include "FirebaseBenchmark.h"
+#include "FirebaseFramePacer.h"
+#include "FirebaseReplay.h"
 #include "FirebaseScene.h"
+#include "FirebaseStartup.h"
 
 #include "firebase/app.h"
 
@@ -61,6 +65,9 @@ static int register_all_packages() {
 }
 
 bool AppDelegate::applicationDidFinishLaunching() {
+  FirebaseStartup::begin();
+  const int directorSetup = FirebaseStartup::beginPhase("Director setup");
+
   // Initialize the director.
   auto director = Director::getInstance();
   auto glview = director->getOpenGLView();
@@ -83,6 +90,15 @@ bool AppDelegate::applicationDidFinishLaunching() {
   // Set FPS. The default value is 1.0 / 60 if this is not called.
   director->setAnimationInterval(1.0f / 60);
 
+  // When the benchmark is enabled, run with a hidden window and no frame cap.
+  // Otherwise lower the frame rate while the scene is idle.
+  FirebaseBenchmark* benchmark = FirebaseBenchmark::createFromEnvironment();
+  if (benchmark) {
+    benchmark->configure(glview);
+  } else {
+    FirebaseFramePacer::start();
+  }
+
   // Set the design resolution.
   glview->setDesignResolutionSize(designResolutionSize.width,
                                   designResolutionSize.height,
@@ -109,26 +125,46 @@ bool AppDelegate::applicationDidFinishLaunching() {
 
   register_all_packages();
 
+#if defined(FIREBASE_COCOS_TRACE)
+  // Record Firebase operations to a Chrome trace file, written when the app
+  // exits or first goes to the background.
+  FirebaseTrace::start(FileUtils::getInstance()->getWritablePath() +
+                       "firebase_trace.json");
+#endif
+#if defined(FIREBASE_COCOS_RECORD_CALLBACKS)
+  // Record the Firebase callbacks this session receives, so they can be
+  // replayed on Linux with FIREBASE_COCOS_REPLAY.
+  FirebaseReplay::startRecording(FileUtils::getInstance()->getWritablePath() +
+                                 "firebase_callbacks.txt");
+#endif
+  FirebaseReplay::startFromEnvironment();
+#if defined(FIREBASE_COCOS_BINARY_LOG)
+  // Also write log messages to firebase_log.bin, which
+  // tools/decode_binary_log.py turns back into text.
+  FirebaseScene::setLogSinks(FirebaseScene::kLogSinkText |
+                             FirebaseScene::kLogSinkBinary);
+#endif
+  FirebaseStartup::endPhase(directorSetup);
+
+  // Show a boot scene right away, then create the Firebase app and the sample
+  // scene while the textures load. App::Create stays on the cocos thread, which
+  // is the thread attached to the JVM on Android.
+  FirebaseStartup::run([]() {
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
-  CCLOG("Initializing Firebase for Android.");
-  firebase::App::Create(firebase::AppOptions(), JniHelper::getEnv(),
-                        JniHelper::getActivity());
+    CCLOG("Initializing Firebase for Android.");
+    firebase::App::Create(firebase::AppOptions(), JniHelper::getEnv(),
+                          JniHelper::getActivity());
 #elif (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-  CCLOG("Initializing Firebase for iOS.");
-  firebase::App::Create(firebase::AppOptions());
+    CCLOG("Initializing Firebase for iOS.");
+    firebase::App::Create(firebase::AppOptions());
 #else
-  CCLOG("Initializing Firebase for Desktop.");
-  CCLOG("Note: Functions in the Firebase C++ desktop API are stubs, and are "
-        "provided for convenience only.");
-  firebase::App::Create(firebase::AppOptions());
+    CCLOG("Initializing Firebase for Desktop.");
+    CCLOG("Note: Functions in the Firebase C++ desktop API are stubs, and are "
+          "provided for convenience only.");
+    firebase::App::Create(firebase::AppOptions());
 #endif
-
-  // Create a scene. Scenes are reference counted and will auto-release on exit.
-  // Currently doesn't compile on desktop. b/34988588
-  auto scene = CreateFirebaseScene();
-
-  // Run the scene.
-  director->runWithScene(scene);
+  });
+  if (benchmark) benchmark->start();
 
   return true;
 }
@@ -138,6 +174,13 @@ bool AppDelegate::applicationDidFinishLaunching() {
 void AppDelegate::applicationDidEnterBackground() {
   Director::getInstance()->stopAnimation();
 
+#if defined(FIREBASE_COCOS_TRACE)
+  // Mobile apps are usually killed in the background rather than exiting, so
+  // write the trace now.
+  FirebaseTrace::finish();
+#endif
+  FirebaseScene::flushLogSinks();
+
   // If you use SimpleAudioEngine, it must be paused.
   // SimpleAudioEngine::getInstance()->pauseBackgroundMusic();
 }
@@ -0,0 +1,193 @@
+#!/usr/bin/python
+# coding=utf-8
+
+# Copyright 2017 Google Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to
+# deal in the Software without restriction, including without limitation the
+# rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+"""Decodes a binary log written by FirebaseBinaryLog into text.
+
+Enable the binary log sink by building the sample with
+FIREBASE_COCOS_BINARY_LOG defined, or by calling:
+
+  FirebaseScene::setLogSinks(FirebaseScene::kLogSinkText |
+                             FirebaseScene::kLogSinkBinary);
+
+then copy firebase_log.bin out of the app's writable directory and run:
+
+  python decode_binary_log.py firebase_log.bin
+
+Each message is printed on its own line, prefixed with its wall clock time and
+log level.
+"""
+
+import argparse
+import datetime
+import re
+import struct
+import sys
+
+MAGIC = b"FBCLOG01"
+FILE_HEADER = struct.Struct("<8sIIQQ")
+RECORD_HEADER = struct.Struct("<IHHIIQ")
+DEFINITION_RECORD = 1
+MESSAGE_RECORD = 2
+# The names of the log levels, indexed by level.
+LEVELS = ["TRACE", "DEBUG", "INFO", "WARN", "ERROR"]
+
+# A printf conversion specification.
+CONVERSION = re.compile(
+    r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L|q)?"
+    r"([diouxXeEfFgGcsp%])")
+
+
+class DecodeError(Exception):
+  pass
+
+
+def read_records(data):
+  """Yields (type, argument_count, format_id, level, timestamp, payload)."""
+  if len(data) < FILE_HEADER.size:
+    raise DecodeError("File is too short to be a binary log.")
+  magic, version, header_size, _, _ = FILE_HEADER.unpack_from(data, 0)
+  if magic != MAGIC or version != 1:
+    raise DecodeError("Not a version 1 binary log.")
+  offset = header_size
+  while offset + RECORD_HEADER.size <= len(data):
+    size, record_type, count, format_id, level, timestamp = (
+        RECORD_HEADER.unpack_from(data, offset))
+    if size == 0:
+      # The end of the log, or a record that was never finished.
+      break
+    if size < RECORD_HEADER.size or offset + size > len(data):
+      raise DecodeError("Corrupt record at offset %d." % offset)
+    payload = data[offset + RECORD_HEADER.size:offset + size]
+    yield record_type, count, format_id, level, timestamp, payload
+    offset += size
+
+
+def read_arguments(payload, count):
+  """Returns the list of decoded argument values in a message payload."""
+  arguments = []
+  offset = 0
+  for _ in range(count):
+    tag = payload[offset:offset + 1]
+    offset += 1
+    if tag == b"s":
+      (length,) = struct.unpack_from("<I", payload, offset)
+      offset += 4
+      value = payload[offset:offset + length].decode("utf-8", "replace")
+      offset += length
+    elif tag == b"i":
+      (value,) = struct.unpack_from("<q", payload, offset)
+      offset += 8
+    elif tag == b"u" or tag == b"p":
+      (value,) = struct.unpack_from("<Q", payload, offset)
+      offset += 8
+    elif tag == b"d":
+      (value,) = struct.unpack_from("<d", payload, offset)
+      offset += 8
+    else:
+      raise DecodeError("Unknown argument tag %r." % tag)
+    arguments.append(value)
+  return arguments
+
+
+def format_message(format_string, arguments):
+  """Applies printf-style arguments to a format string."""
+  arguments = list(arguments)
+  output = []
+  position = 0
+
+  def next_argument():
+    return arguments.pop(0) if arguments else 0
+
+  for match in CONVERSION.finditer(format_string):
+    output.append(format_string[position:match.start()])
+    position = match.end()
+    flags, width, precision, _, conversion = match.groups()
+    if conversion == "%":
+      output.append("%")
+      continue
+    if width == "*":
+      width = str(next_argument())
+    if precision == "*":
+      precision = str(next_argument())
+    spec = "%" + flags + (width or "")
+    if precision is not None:
+      spec += "." + precision
+    value = next_argument()
+    if conversion == "p":
+      output.append((spec + "s") % ("0x%x" % value))
+    elif conversion == "c":
+      output.append((spec + "s") % chr(value))
+    elif conversion == "s" or isinstance(value, type(u"")):
+      output.append((spec + "s") % value)
+    elif conversion in "diu":
+      output.append((spec + "d") % int(value))
+    else:
+      output.append((spec + conversion) % value)
+  output.append(format_string[position:])
+  return "".join(output)
+
+
+def decode(data, out):
+  """Writes the messages in the binary log `data` to `out`."""
+  _, _, _, wall_clock, steady_clock = FILE_HEADER.unpack_from(data, 0)
+  records = list(read_records(data))
+  # Definitions may follow the first message that uses them, so collect them
+  # all before decoding any messages.
+  formats = {}
+  for record_type, _, format_id, _, _, payload in records:
+    if record_type == DEFINITION_RECORD:
+      (length,) = struct.unpack_from("<I", payload, 0)
+      formats[format_id] = payload[4:4 + length].decode("utf-8", "replace")
+  start = datetime.datetime.utcfromtimestamp(wall_clock / 1e9)
+  for record_type, count, format_id, level, timestamp, payload in records:
+    if record_type != MESSAGE_RECORD:
+      continue
+    arguments = read_arguments(payload, count)
+    if format_id in formats:
+      text = format_message(formats[format_id], arguments)
+    else:
+      text = "<unknown format %d> %s" % (
+          format_id, " ".join(str(a) for a in arguments))
+    when = start + datetime.timedelta(
+        microseconds=(timestamp - steady_clock) / 1e3)
+    level_name = LEVELS[level] if level < len(LEVELS) else str(level)
+    out.write("%s %-5s %s\n" % (when.strftime("%H:%M:%S.%f"), level_name,
+                                text))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description="Decodes a binary log written by FirebaseBinaryLog.")
+  parser.add_argument("log_file", help="The binary log file to decode.")
+  args = parser.parse_args()
+  with open(args.log_file, "rb") as log_file:
+    data = log_file.read()
+  try:
+    decode(data, sys.stdout)
+  except DecodeError as error:
+    sys.stderr.write("%s\n" % error)
+    return 1
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())